@@ -320,6 +320,11 @@ int totalTimeAcc, satelliteMovementAcc, pixelColoringAcc, frameCount;
 int previousFinishTime = 0;
 unsigned int frameNumber = 0;
 unsigned int seed = 0;
+// Frames to run without a window (--headless), 0 means interactive mode
+unsigned int headlessFrames = 0;
+// Failed pixel and satellite checks of a headless run, which cannot wait
+// for enter and fails at the end instead
+unsigned int failedChecks = 0;
 
 // ¤¤ DO NOT EDIT THIS FUNCTION ¤¤
 // Sequential rendering loop used for finding errors
@@ -480,6 +485,11 @@ void errorCheck(){
                 correctPixels[i].red, correctPixels[i].green, correctPixels[i].blue);
          countErrors++;
          if (countErrors > ALLOWED_NUMBER_OF_ERRORS) {
+            if (headlessFrames) {
+               printf("Too many errors (%d) in frame %d\n", countErrors, frameNumber);
+               failedChecks++;
+               return;
+            }
             printf("Too many errors (%d) in frame %d, Press enter to continue.\n", countErrors, frameNumber);
             getchar();
             return;
@@ -500,7 +510,7 @@ void compute(void){
       sequentialPhysicsEngine(backupSatelites);
       mousePosX = HORIZONTAL_CENTER;
       mousePosY = VERTICAL_CENTER;
-   } else {
+   } else if (!headlessFrames) {
       SDL_GetMouseState(&mousePosX, &mousePosY);
       if ((mousePosX == 0) && (mousePosY == 0)) {
          mousePosX = HORIZONTAL_CENTER;
@@ -512,7 +522,11 @@ void compute(void){
       for (int i = 0; i < SATELLITE_COUNT; i++) {
          if (memcmp (&satellites[i], &backupSatelites[i], sizeof(satellite))) {
             printf("Incorrect satellite data of satellite: %d\n", i);
-            getchar();
+            if (headlessFrames) {
+               failedChecks++;
+            } else {
+               getchar();
+            }
          }
       }
    }
@@ -638,15 +652,63 @@ void render(void){
    frameNumber++;
 }
 
+// Runs headlessFrames frames without a window and prints a timing summary.
+// The black hole stays in the center, so runs are comparable. Returns the
+// exit code, 1 when a pixel or satellite check failed.
+int runHeadless(void){
+   int startTime = SDL_GetTicks();
+   while (frameNumber < headlessFrames) {
+      compute();
+      frameNumber++;
+   }
+   int wallTime = SDL_GetTicks() - startTime;
+
+   // One JSON line, the timed frames are the ones after the error check frames
+   int timedFrames = frameCount > 0 ? frameCount : 1;
+   printf("{\"variant\":\"%s\",\"frames\":%u,\"timed_frames\":%d,\"wall_ms\":%d,"
+          "\"physics_ms_avg\":%.3f,\"graphics_ms_avg\":%.3f,\"frame_ms_avg\":%.3f,"
+          "\"failed_checks\":%u}\n",
+          "Satellites2omp", headlessFrames, frameCount, wallTime,
+          (double)satelliteMovementAcc / timedFrames,
+          (double)pixelColoringAcc / timedFrames,
+          (double)totalTimeAcc / timedFrames, failedChecks);
+   return failedChecks ? 1 : 0;
+}
+
 // DO NOT EDIT THIS FUNCTION
 // Inits render window and starts mainloop
 int main(int argc, char** argv){
 
-   if(argc > 1){
+   if(argc > 1 && strncmp(argv[1], "--", 2)){
      seed = atoi(argv[1]);
      printf("Using seed: %i\n", seed);
    }
 
+   // parse optional --headless flag
+   for (int i = 1; i < argc; ++i) {
+      if (!strcmp(argv[i], "--headless") && i+1 < argc) {
+         char *end;
+         long frames = strtol(argv[++i], &end, 10);
+         if (end == argv[i] || *end != '\0' || frames <= 0 || frames > 1000000000L) {
+            printf("Invalid headless: %s\n", argv[i]);
+            return 1;
+         }
+         headlessFrames = (unsigned int)frames;
+         printf("Running headless for %u frames\n", headlessFrames);
+      }
+   }
+
+   if (headlessFrames) {
+      // No window or display, only the timer is needed
+      SDL_Init(SDL_INIT_TIMER);
+      fixedInit(seed);
+      init();
+      int exitCode = runHeadless();
+      SDL_Quit();
+      fixedDestroy();
+      return exitCode;
+   }
+
    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER);
    win = SDL_CreateWindow(
         "Satellites",
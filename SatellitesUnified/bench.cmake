@@ -0,0 +1,175 @@
+# Parameter sweep driver for the unified executable, run by the 'bench'
+# target (cmake --build <build> --target bench) or directly with
+#   cmake -DEXE=<build>/parallel -DBINARY_DIR=<build> -P bench.cmake
+#
+# Every combination of the parameters (satellite count, resolution,
+# physics substeps, engines, OpenMP threads, OpenCL local size) is run
+# headless for FRAMES frames with the same executable. The results go to
+# <OUTPUT>.csv and <OUTPUT>.json.
+#
+# Lists are comma separated:
+#   SATELLITE_COUNTS  64,256
+#   RESOLUTIONS       1920x1024,3840x2160
+#   SUBSTEPS          100000
+#   THREADS           1,8
+#   LOCAL_SIZES       0,64,256   (0 lets the runtime decide, only used with opencl engines)
+#   ENGINES           openmp:openmp,openmp:opencl   (physics:graphics)
+#
+# TRAJECTORY is an optional black hole trajectory replayed in every run
+# (see trajectory.h), relative paths are relative to the executable.
+
+cmake_minimum_required(VERSION 3.12)
+
+if (NOT EXE OR NOT BINARY_DIR)
+    message(FATAL_ERROR "EXE and BINARY_DIR must be given")
+endif()
+# parallel.cl is looked up from the working directory
+get_filename_component(EXE_DIR "${EXE}" DIRECTORY)
+
+cmake_host_system_information(RESULT HOST_CORES QUERY NUMBER_OF_LOGICAL_CORES)
+
+# Defaults for everything that was not given
+if (NOT FRAMES)
+    set(FRAMES 13)
+endif()
+if (NOT SEED)
+    set(SEED 1)
+endif()
+if (NOT SATELLITE_COUNTS)
+    set(SATELLITE_COUNTS 64)
+endif()
+if (NOT RESOLUTIONS)
+    set(RESOLUTIONS 1920x1024)
+endif()
+if (NOT SUBSTEPS)
+    set(SUBSTEPS 100000)
+endif()
+if (NOT THREADS)
+    set(THREADS "1,${HOST_CORES}")
+endif()
+if (NOT LOCAL_SIZES)
+    set(LOCAL_SIZES 0)
+endif()
+if (NOT ENGINES)
+    set(ENGINES openmp:openmp)
+endif()
+if (NOT OUTPUT)
+    set(OUTPUT "${BINARY_DIR}/bench")
+endif()
+
+foreach(list SATELLITE_COUNTS RESOLUTIONS SUBSTEPS THREADS LOCAL_SIZES ENGINES)
+    string(REPLACE "," ";" ${list} "${${list}}")
+endforeach()
+list(REMOVE_DUPLICATES THREADS)
+
+if (WIN32)
+    set(NULL_DEVICE NUL)
+else()
+    set(NULL_DEVICE /dev/null)
+endif()
+
+# Pulls "key":number out of a JSON fragment
+function(json_number out json key)
+    string(REGEX MATCH "\"${key}\":([0-9.eE+-]+)" match "${json}")
+    set(${out} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+endfunction()
+
+# Pulls the "stage":{...} object out of the stages member
+function(json_stage out json stage)
+    string(REGEX MATCH "\"${stage}\":[{][^}]*[}]" match "${json}")
+    set(${out} "${match}" PARENT_SCOPE)
+endfunction()
+
+set(CSV_HEADER "satellites,width,height,substeps,threads,local_size,physics,graphics,timed_frames,physics_ms_mean,physics_ms_p50,physics_ms_p99,graphics_ms_mean,graphics_ms_p50,graphics_ms_p99,frame_ms_mean,frame_ms_p50,frame_ms_p99,accuracy_passed,psnr_db,force_evaluations")
+file(WRITE "${OUTPUT}.csv" "${CSV_HEADER}\n")
+set(JSON_ROWS "")
+
+foreach(satelliteCount ${SATELLITE_COUNTS})
+foreach(resolution ${RESOLUTIONS})
+foreach(substeps ${SUBSTEPS})
+    string(REPLACE "x" ";" size "${resolution}")
+    list(GET size 0 width)
+    list(GET size 1 height)
+
+    foreach(engines ${ENGINES})
+        string(REPLACE ":" ";" enginePair "${engines}")
+        list(GET enginePair 0 physics)
+        list(GET enginePair 1 graphics)
+
+        # The local size only matters when OpenCL does some of the work
+        if (physics STREQUAL "opencl" OR graphics STREQUAL "opencl")
+            set(localSizes ${LOCAL_SIZES})
+        else()
+            set(localSizes "-")
+        endif()
+
+        foreach(threads ${THREADS})
+        foreach(localSize ${localSizes})
+            message(STATUS "${satelliteCount} satellites, ${width}x${height}, ${substeps} substeps, "
+                           "${physics}/${graphics}, ${threads} threads, local size ${localSize}")
+            set(localArgs "")
+            if (NOT localSize STREQUAL "-")
+                set(localArgs --local ${localSize})
+            endif()
+            if (TRAJECTORY)
+                list(APPEND localArgs --replay "${TRAJECTORY}")
+            endif()
+            execute_process(
+                COMMAND ${CMAKE_COMMAND} -E env OMP_NUM_THREADS=${threads}
+                        "${EXE}" ${SEED} --headless ${FRAMES}
+                        --satellites ${satelliteCount} --width ${width} --height ${height}
+                        --substeps ${substeps}
+                        --physics ${physics} --graphics ${graphics} ${localArgs}
+                WORKING_DIRECTORY "${EXE_DIR}"
+                INPUT_FILE ${NULL_DEVICE}
+                OUTPUT_VARIABLE runOutput
+                RESULT_VARIABLE result)
+            string(REGEX MATCH "[{]\"physics\":[^\n]*" summary "${runOutput}")
+            # Exit code 2 is a failed correctness check, the run is still recorded
+            if (NOT (result EQUAL 0 OR result EQUAL 2) OR NOT summary)
+                message(WARNING "Run failed (${result}), skipping:\n${runOutput}")
+                continue()
+            endif()
+
+            # No local size is empty in the CSV and null in the JSON
+            if (localSize STREQUAL "-")
+                set(csvLocalSize "")
+                set(jsonLocalSize null)
+            else()
+                set(csvLocalSize ${localSize})
+                set(jsonLocalSize ${localSize})
+            endif()
+
+            json_number(timedFrames "${summary}" timed_frames)
+            set(row "${satelliteCount},${width},${height},${substeps},${threads},${csvLocalSize},${physics},${graphics},${timedFrames}")
+            foreach(stage physics graphics frame)
+                json_stage(stageJson "${summary}" ${stage})
+                foreach(key mean_ms p50_ms p99_ms)
+                    json_number(value "${stageJson}" ${key})
+                    string(APPEND row ",${value}")
+                endforeach()
+            endforeach()
+            string(REGEX MATCH "\"passed\":(true|false)" match "${summary}")
+            set(passed "${CMAKE_MATCH_1}")
+            if (NOT passed STREQUAL "true")
+                message(WARNING "Correctness check failed")
+            endif()
+            json_number(psnr "${summary}" psnr_db)
+            string(REGEX MATCH "\"force_evaluations\":[{][^}]*[}]" evaluationsJson "${summary}")
+            json_number(evaluations "${evaluationsJson}" mean)
+            string(APPEND row ",${passed},${psnr},${evaluations}")
+            file(APPEND "${OUTPUT}.csv" "${row}\n")
+
+            string(REGEX REPLACE "^[{]" "" summaryMembers "${summary}")
+            # The summary already has the sizes and the engines
+            list(APPEND JSON_ROWS "{\"threads\":${threads},\"local_size\":${jsonLocalSize},${summaryMembers}")
+        endforeach()
+        endforeach()
+    endforeach()
+endforeach()
+endforeach()
+endforeach()
+
+string(REPLACE ";" ",\n  " JSON_BODY "${JSON_ROWS}")
+file(WRITE "${OUTPUT}.json" "[\n  ${JSON_BODY}\n]\n")
+message(STATUS "Results written to ${OUTPUT}.csv and ${OUTPUT}.json")
@@ -0,0 +1,267 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h> // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
+#include "checkpoint.h"
+#include "integrator.h"
+#include "timing.h"
+#include "trace.h"
+
+// Largest window edge and substep count a checkpoint may ask for
+#define CHECKPOINT_MAX_EDGE 32768
+#define CHECKPOINT_MAX_SUBSTEPS 1000000000
+
+static char checkpointPath[512];
+static char temporaryPath[520];
+static unsigned int checkpointEvery = 0;
+
+// The state the thread writes
+static CheckpointHeader jobHeader;
+static satellite *jobSats = NULL;
+static int jobCapacity = 0;
+
+static SDL_Thread *thread = NULL;
+static SDL_sem *jobReady = NULL;
+static SDL_sem *jobDone = NULL;
+static SDL_atomic_t stopping;
+// Main thread only: the job is handed over and its jobDone not taken yet
+static int queued = 0;
+
+// Written by the thread, read after checkpointDestroy()
+static unsigned int written = 0, failed = 0;
+static uint64_t writeTime = 0;
+static uint64_t bytesWritten = 0;
+// Main thread only
+static unsigned int skipped = 0;
+static uint64_t copyTime = 0;
+
+#define FNV1A_START 0xcbf29ce484222325ull
+
+// Continues the FNV-1a hash over bytes more bytes
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes){
+   const unsigned char *p = (const unsigned char*)data;
+   for (size_t i = 0; i < bytes; ++i) {
+      hash ^= p[i];
+      hash *= 0x100000001b3ull;
+   }
+   return hash;
+}
+
+// Hash of the header, with checksum counted as 0, and the satellites
+static uint64_t checksum(const CheckpointHeader *header, const satellite *sats, size_t bytes){
+   CheckpointHeader copy = *header;
+   copy.checksum = 0;
+   return fnv1a(fnv1a(FNV1A_START, &copy, sizeof(copy)), sats, bytes);
+}
+
+// Pushes the data of f to the disk, so that the rename cannot land before it
+static int syncFile(FILE *f){
+   if (fflush(f)) {
+      return -1;
+   }
+#ifdef _WIN32
+   return _commit(_fileno(f));
+#else
+   return fsync(fileno(f));
+#endif
+}
+
+static int writeCheckpoint(void){
+   size_t bytes = sizeof(satellite) * jobHeader.satelliteCount;
+   jobHeader.checksum = checksum(&jobHeader, jobSats, bytes);
+   FILE *f = fopen(temporaryPath, "wb");
+   if (!f) {
+      return -1;
+   }
+   int ok = fwrite(&jobHeader, sizeof(jobHeader), 1, f) == 1 &&
+            (bytes == 0 || fwrite(jobSats, bytes, 1, f) == 1) &&
+            syncFile(f) == 0;
+   ok = fclose(f) == 0 && ok;
+   if (!ok) {
+      remove(temporaryPath);
+      return -1;
+   }
+#ifdef _WIN32
+   // rename() does not replace an existing file on Windows
+   remove(checkpointPath);
+#endif
+   if (rename(temporaryPath, checkpointPath)) {
+      return -1;
+   }
+   bytesWritten += sizeof(jobHeader) + bytes;
+   return 0;
+}
+
+static int checkpointThread(void *data){
+   (void)data;
+   for (;;) {
+      SDL_SemWait(jobReady);
+      if (SDL_AtomicGet(&stopping)) {
+         break;
+      }
+      uint64_t start = timingNow();
+      if (writeCheckpoint()) {
+         failed++;
+         printf("Cannot write checkpoint: %s\n", checkpointPath);
+      } else {
+         written++;
+      }
+      uint64_t end = timingNow();
+      writeTime += end - start;
+      traceSpan("checkpoint", "checkpoint", TRACE_TID_CHECKPOINT, start, end,
+                "frame", jobHeader.frame);
+      SDL_SemPost(jobDone);
+   }
+   return 0;
+}
+
+void checkpointInit(const char *path, unsigned int every){
+   snprintf(checkpointPath, sizeof(checkpointPath), "%s", path);
+   snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+   checkpointEvery = every;
+   SDL_AtomicSet(&stopping, 0);
+   jobReady = SDL_CreateSemaphore(0);
+   jobDone = SDL_CreateSemaphore(0);
+   thread = SDL_CreateThread(checkpointThread, "checkpoint", NULL);
+   if (every) {
+      printf("Checkpoint every %u frames and at exit to %s\n", every, checkpointPath);
+   } else {
+      printf("Checkpoint at exit to %s\n", checkpointPath);
+   }
+}
+
+int checkpointDue(unsigned int frame){
+   return thread && checkpointEvery && frame % checkpointEvery == 0;
+}
+
+int checkpointSave(const CheckpointHeader *state, const satellite *sats, int wait){
+   if (!thread) {
+      return 0;
+   }
+   if (queued) {
+      if (wait) {
+         SDL_SemWait(jobDone);
+      } else if (SDL_SemTryWait(jobDone)) {
+         skipped++;
+         return 0;
+      }
+      queued = 0;
+   }
+   uint64_t start = timingNow();
+   int count = state->satelliteCount;
+   if (count > jobCapacity) {
+      alignedFree(jobSats);
+      jobSats = (satellite*)alignedAlloc(sizeof(satellite) * count);
+      if (!jobSats) {
+         printf("Out of memory for a checkpoint of %d satellites\n", count);
+         exit(-1);
+      }
+      jobCapacity = count;
+   }
+   memcpy(jobSats, sats, sizeof(satellite) * count);
+   jobHeader = *state;
+   memcpy(jobHeader.magic, CHECKPOINT_MAGIC, sizeof(jobHeader.magic));
+   jobHeader.version = CHECKPOINT_VERSION;
+   jobHeader.byteOrder = CHECKPOINT_BYTE_ORDER;
+   jobHeader.headerBytes = sizeof(CheckpointHeader);
+   jobHeader.satelliteBytes = sizeof(satellite);
+   copyTime += timingNow() - start;
+   SDL_SemPost(jobReady);
+   queued = 1;
+   if (wait) {
+      SDL_SemWait(jobDone);
+      queued = 0;
+   }
+   return 1;
+}
+
+void checkpointDestroy(void){
+   if (!thread) {
+      return;
+   }
+   if (queued) {
+      SDL_SemWait(jobDone);
+      queued = 0;
+   }
+   SDL_AtomicSet(&stopping, 1);
+   SDL_SemPost(jobReady);
+   SDL_WaitThread(thread, NULL);
+   SDL_DestroySemaphore(jobReady);
+   SDL_DestroySemaphore(jobDone);
+   thread = NULL;
+   alignedFree(jobSats);
+   jobSats = NULL;
+   jobCapacity = 0;
+}
+
+int checkpointLoad(const char *path, CheckpointHeader *header, satellite **sats){
+   FILE *f = fopen(path, "rb");
+   if (!f) {
+      printf("Cannot open checkpoint: %s\n", path);
+      return -1;
+   }
+   if (fread(header, sizeof(*header), 1, f) != 1 ||
+       memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic))) {
+      printf("Not a checkpoint: %s\n", path);
+      fclose(f);
+      return -1;
+   }
+   if (header->version != CHECKPOINT_VERSION || header->byteOrder != CHECKPOINT_BYTE_ORDER ||
+       header->satelliteBytes != sizeof(satellite) || header->headerBytes < sizeof(*header)) {
+      printf("Unsupported checkpoint %s: version %u, byte order %08x, %u byte satellites\n",
+             path, header->version, header->byteOrder, header->satelliteBytes);
+      fclose(f);
+      return -1;
+   }
+   // The checksum is only known after the satellites are read, so the
+   // fields that size the buffers are checked first, against the file size
+   long fileBytes = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+   if (header->satelliteCount <= 0 || fileBytes < (long)header->headerBytes ||
+       (unsigned long)(fileBytes - header->headerBytes) / sizeof(satellite) <
+          (unsigned long)header->satelliteCount ||
+       header->width <= 0 || header->width > CHECKPOINT_MAX_EDGE ||
+       header->height <= 0 || header->height > CHECKPOINT_MAX_EDGE ||
+       header->substeps <= 0 || header->substeps > CHECKPOINT_MAX_SUBSTEPS ||
+       header->integrator < 0 || header->integrator >= INTEGRATOR_COUNT) {
+      printf("Checkpoint %s is truncated or damaged: %d satellites, %dx%d, %d substeps\n",
+             path, header->satelliteCount, header->width, header->height, header->substeps);
+      fclose(f);
+      return -1;
+   }
+   size_t bytes = sizeof(satellite) * header->satelliteCount;
+   *sats = (satellite*)alignedAlloc(bytes);
+   if (!*sats) {
+      printf("Out of memory for a checkpoint of %d satellites\n", header->satelliteCount);
+      exit(-1);
+   }
+   int ok = fseek(f, header->headerBytes, SEEK_SET) == 0 && fread(*sats, bytes, 1, f) == 1;
+   fclose(f);
+   if (!ok || checksum(header, *sats, bytes) != header->checksum) {
+      printf("Checkpoint %s is truncated or damaged\n", path);
+      alignedFree(*sats);
+      *sats = NULL;
+      return -1;
+   }
+   return 0;
+}
+
+void checkpointPrint(void){
+   if (!written && !failed && !skipped) {
+      return;
+   }
+   printf("Checkpoints: %u written (%.1f MB), %u failed, %u skipped while busy, "
+          "frame loop %.3f ms, writer thread %.3f ms\n",
+          written, bytesWritten / 1e6, failed, skipped, copyTime / 1e6, writeTime / 1e6);
+}
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Checkpoints of the simulation ¤¤                             //
+//                                                                    //
+//    A checkpoint is a 128 byte header followed by the satellite     //
+//    array exactly as it is in memory, starting at headerBytes (a    //
+//    multiple of 64), so the block can be used straight from a       //
+//    memory mapped file. Numbers are in the byte order of the        //
+//    machine, byteOrder tells which one. The files are written on a  //
+//    separate thread to a temporary file, synced to the disk, which  //
+//    then replaces the previous checkpoint, so a crash or a power    //
+//    loss leaves either the old or the new checkpoint in place.      //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "satellites.h"
+
+#define CHECKPOINT_MAGIC "SATCKPT"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_BYTE_ORDER 0x01020304u
+
+typedef struct {
+   char magic[8];             // CHECKPOINT_MAGIC
+   uint32_t version;          // CHECKPOINT_VERSION
+   uint32_t byteOrder;        // CHECKPOINT_BYTE_ORDER as written
+   uint32_t headerBytes;      // offset of the satellite block
+   uint32_t satelliteBytes;   // sizeof(satellite)
+   int32_t satelliteCount;
+   uint32_t frame;            // the next frame to compute
+   int32_t mouseX;            // black hole of the last frame
+   int32_t mouseY;
+   int32_t width;
+   int32_t height;
+   int32_t substeps;
+   int32_t integrator;
+   uint32_t seed;
+   uint32_t samplerRandom;    // state of the --sample-every picks
+   uint32_t reserved0;
+   uint64_t checksum;         // FNV-1a of the header (this field as 0) and satellites
+   uint8_t reserved[48];
+} CheckpointHeader;
+static_assert(sizeof(CheckpointHeader) == 128, "CheckpointHeader must be 128 bytes");
+
+// Starts the writer thread, checkpoints then go to path every `every`
+// frames (see checkpointDue()) and when the program ends
+void checkpointInit(const char *path, unsigned int every);
+// 1 when frame should be saved
+int checkpointDue(unsigned int frame);
+
+// Copies the state for the writer thread. When the previous checkpoint is
+// still being written the frame is skipped, unless wait is set. Returns 0
+// when it was skipped.
+int checkpointSave(const CheckpointHeader *state, const satellite *sats, int wait);
+
+// Waits for the last checkpoint and stops the thread
+void checkpointDestroy(void);
+
+// Reads and checks a checkpoint. *sats gets an alignedAlloc() array of
+// header->satelliteCount satellites. Returns 0 on success.
+int checkpointLoad(const char *path, CheckpointHeader *header, satellite **sats);
+
+void checkpointPrint(void);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Physics with the analytic two-body solution ¤¤               //
+//                                                                    //
+//    Every satellite only feels the black hole, so its orbit is a    //
+//    Kepler orbit. Instead of 100000 Euler substeps the satellite    //
+//    is moved along the orbit by DELTATIME in one go, with the       //
+//    universal variable formulation (valid for ellipses, parabolas   //
+//    and hyperbolas). The result differs from the Euler reference    //
+//    by the error of the Euler integration, see KEPLER_TOLERANCE.    //
+////////////////////////////////////////////////////////////////////////
+
+#include "satellites.h"
+
+#include <math.h>
+
+// Allowed distance from the Euler reference after one frame, in pixels
+#define KEPLER_TOLERANCE 0.05
+
+#define KEPLER_MAX_ITERATIONS 50
+
+// Stumpff functions C(z) and S(z)
+static double stumpffC(double z){
+   if (z > 1e-6) {
+      return (1.0 - cos(sqrt(z))) / z;
+   }
+   if (z < -1e-6) {
+      return (cosh(sqrt(-z)) - 1.0) / -z;
+   }
+   // Series near 0
+   return 1.0/2.0 - z/24.0 + z*z/720.0;
+}
+
+static double stumpffS(double z){
+   if (z > 1e-6) {
+      double sz = sqrt(z);
+      return (sz - sin(sz)) / (sz * z);
+   }
+   if (z < -1e-6) {
+      double sz = sqrt(-z);
+      return (sinh(sz) - sz) / (sz * -z);
+   }
+   return 1.0/6.0 - z/120.0 + z*z/5040.0;
+}
+
+// Moves one satellite by dt around a body of gravitational parameter mu
+// at the origin. position and velocity are relative to the body.
+static void keplerPropagate(doublevector *position, doublevector *velocity,
+                            double mu, double dt){
+   double r0 = sqrt(position->x * position->x + position->y * position->y);
+   if (r0 < 1e-12) {
+      return; // In the singularity, nothing sensible to do
+   }
+   double v2 = velocity->x * velocity->x + velocity->y * velocity->y;
+   double sqrtMu = sqrt(mu);
+   double vr0 = (position->x * velocity->x + position->y * velocity->y) / r0;
+   // Reciprocal of the semi-major axis, negative for hyperbolas
+   double alpha = 2.0 / r0 - v2 / mu;
+
+   // Newton iteration for the universal anomaly chi
+   double chi = sqrtMu * fabs(alpha) * dt;
+   if (chi == 0.0) {
+      chi = sqrtMu * dt / r0;
+   }
+   for (int i = 0; i < KEPLER_MAX_ITERATIONS; ++i) {
+      double chi2 = chi * chi;
+      double z = alpha * chi2;
+      double c = stumpffC(z);
+      double s = stumpffS(z);
+      double f = r0 * vr0 / sqrtMu * chi2 * c + (1.0 - alpha * r0) * chi2 * chi * s +
+                 r0 * chi - sqrtMu * dt;
+      double df = r0 * vr0 / sqrtMu * chi * (1.0 - z * s) +
+                  (1.0 - alpha * r0) * chi2 * c + r0;
+      double step = f / df;
+      chi -= step;
+      if (fabs(step) <= 1e-12 * (fabs(chi) + 1.0)) {
+         break;
+      }
+   }
+
+   // Lagrange coefficients
+   double chi2 = chi * chi;
+   double z = alpha * chi2;
+   double c = stumpffC(z);
+   double s = stumpffS(z);
+   double f = 1.0 - chi2 / r0 * c;
+   double g = dt - chi2 * chi / sqrtMu * s;
+   doublevector newPosition = {.x = f * position->x + g * velocity->x,
+                               .y = f * position->y + g * velocity->y};
+   double r = sqrt(newPosition.x * newPosition.x + newPosition.y * newPosition.y);
+   double fDot = sqrtMu / (r * r0) * (alpha * chi2 * chi * s - chi);
+   double gDot = 1.0 - chi2 / r * c;
+   doublevector newVelocity = {.x = fDot * position->x + gDot * velocity->x,
+                               .y = fDot * position->y + gDot * velocity->y};
+   *position = newPosition;
+   *velocity = newVelocity;
+}
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+// The cost is one Kepler solve per satellite instead of one per substep
+static void keplerPhysicsRun(satellite *sats, int count, int mouseX, int mouseY){
+
+   int i;
+   #pragma omp parallel for schedule(static)
+   for (i = 0; i < count; ++i) {
+      // Relative to the black hole, in double precision
+      doublevector position = {.x = (double)sats[i].position.x - mouseX,
+                               .y = (double)sats[i].position.y - mouseY};
+      doublevector velocity = {.x = sats[i].velocity.x, .y = sats[i].velocity.y};
+
+      keplerPropagate(&position, &velocity, GRAVITY, DELTATIME);
+
+      sats[i].position.x = position.x + mouseX;
+      sats[i].position.y = position.y + mouseY;
+      sats[i].velocity.x = velocity.x;
+      sats[i].velocity.y = velocity.y;
+   }
+}
+
+static void keplerInit(void){
+}
+
+static void keplerDestroy(void){
+}
+
+const PhysicsEngine keplerPhysics = {
+   .name = "kepler",
+   .init = keplerInit,
+   .destroy = keplerDestroy,
+   .run = keplerPhysicsRun,
+   .tolerance = KEPLER_TOLERANCE
+};
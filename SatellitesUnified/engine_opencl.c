@@ -0,0 +1,1119 @@
+/* COMP.CE.350 Vector Addition with OpenCL
+   Copyright (c) 2024 Topi Leppanen  topi.leppanen@tuni.fi
+*/
+
+//////////////////////////////////////////////////////////////////////
+// ¤¤ Physics computing and Graphic rendering both on GPU kernel ¤¤ //
+//                                                                  //
+//    Same code as Satellites2kernel, the kernels are in            //
+//    parallel.cl which must be next to the executable              //
+//////////////////////////////////////////////////////////////////////
+
+#include "integrator.h"
+#include "satellites.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <math.h>
+#include <stdio.h>  // printf
+#include <stdlib.h>
+#include <string.h>
+
+#define CL_TARGET_OPENCL_VERSION 120
+
+#ifndef __APPLE__
+#include <CL/cl.h>
+#else
+#include <OpenCL/cl.h>
+#endif
+
+typedef struct {
+    int32_t   substeps;    // physicsUpdatesPerFrame
+    float     gravity;     // GRAVITY
+    float     dt;          // DELTATIME
+    int32_t   mouseX;      // from input
+    int32_t   mouseY;
+    int32_t   satCount;    // satellites in this call
+    int32_t   integrator;  // Integrator of integrator.h
+    float     adaptiveEta; // --adaptive, 0 for equal substeps
+} PhysParams;
+static_assert(sizeof(PhysParams) == 8*4, "PhysParams must be 32 bytes");
+
+
+// Parameters structure for OpenCL kernel
+// Contains all constants needed for rendering (window dimensions, mouse position, radii, satellite count)
+typedef struct {
+    int32_t width;              // Window width in pixels
+    int32_t height;             // Window height in pixels
+    int32_t mouseX;             // Mouse X position (black hole center)
+    int32_t mouseY;             // Mouse Y position (black hole center)
+    float   blackHoleRadius2;   // Black hole radius squared (for fast distance comparison)
+    float   satelliteRadius2;   // Satellite radius squared (for hit detection)
+    int32_t satCount;           // Total number of satellites
+} GraphicParams;
+// Ensure struct is exactly 28 bytes (7 fields × 4 bytes each) for proper alignment
+static_assert(sizeof(GraphicParams) == 7*4, "GraphicParams must be 28 bytes");
+
+size_t localSize = 0;
+
+// Number of engines (physics and/or graphics) using the OpenCL context
+static int oclUsers = 0;
+
+static cl_context        context = NULL;
+static cl_command_queue  commandQueue = NULL;
+static cl_device_id      device = NULL;
+static cl_program        program = NULL;
+static char             *programSource = NULL; // kept for the float physics program
+static int               deviceFp64 = 0;       // cl_khr_fp64 supported
+
+static cl_mem            bufSats = NULL;
+static size_t            satelliteBytes;   // capacity of bufSats
+
+static cl_kernel         kernelCompute = NULL; // one of the two below
+static cl_kernel         kernelComputeDouble = NULL;
+static cl_kernel         kernelComputeFloat = NULL;
+static cl_program        programFloat = NULL;  // physics_compute_float, built when needed
+static cl_mem            bufPhysParams = NULL; // physics params
+static size_t            physParamsBytes = 0;
+static cl_mem            bufEvaluations = NULL; // force evaluations per satellite (--adaptive)
+static cl_uint          *hostEvaluations = NULL;
+
+static cl_kernel         kernelRender = NULL;
+static cl_kernel         kernelRenderTiled = NULL; // --tile
+static size_t            tileSize = 0;             // work-group edge of kernelRenderTiled
+static cl_mem            bufGraphicParams = NULL; // graphic params
+static cl_mem            bufPixels = NULL;
+static size_t            graphicParamsBytes, pixelBytes;
+
+// ======= Profiling (--cl-profile) =======
+// Every write, kernel and read gets an event. Once the call has finished
+// the device timestamps go to the CSV file and to two histograms per
+// command: queued -> start (waiting) and start -> end (running).
+int clProfiling = 0;
+static FILE *profileFile = NULL;
+static unsigned int physicsCalls = 0, graphicsCalls = 0;
+
+enum {
+    PROFILE_PHYSICS_WRITE_SATELLITES,
+    PROFILE_PHYSICS_WRITE_PARAMS,
+    PROFILE_PHYSICS_KERNEL,
+    PROFILE_PHYSICS_READ_SATELLITES,
+    PROFILE_GRAPHICS_WRITE_SATELLITES,
+    PROFILE_GRAPHICS_WRITE_PARAMS,
+    PROFILE_GRAPHICS_KERNEL,
+    PROFILE_GRAPHICS_READ_PIXELS,
+    PROFILE_COMMANDS
+};
+
+typedef struct {
+    const char *name;
+    TimingHistogram wait;   // queued -> start
+    TimingHistogram run;    // start -> end
+} CommandProfile;
+
+static CommandProfile profiles[PROFILE_COMMANDS] = {
+    {.name = "physics_write_satellites"},
+    {.name = "physics_write_params"},
+    {.name = "physics_kernel"},
+    {.name = "physics_read_satellites"},
+    {.name = "graphics_write_satellites"},
+    {.name = "graphics_write_params"},
+    {.name = "graphics_kernel"},
+    {.name = "graphics_read_pixels"},
+};
+
+// ======= Physics precision (--cl-precision) =======
+// physics_compute works in double. physics_compute_float only needs float
+// and keeps the state as two-float numbers, for devices without fp64 or
+// with a small fp64 rate. auto takes the float kernel when there is no
+// fp64 or when it is clearly faster on a short probe.
+enum {
+    CL_PRECISION_AUTO,
+    CL_PRECISION_DOUBLE,
+    CL_PRECISION_FLOAT
+};
+static const char *precisionNames[] = {"auto", "double", "float"};
+static int clPrecision = CL_PRECISION_AUTO;
+static int floatPhysics = 0; // physics_compute_float was selected
+
+// Allowed distance of the float kernel from the reference after one
+// frame, in pixels. A frame of 100000 substeps stays within a float ulp.
+#define FLOAT_PHYSICS_TOLERANCE 0.001
+
+// Probe that times both kernels with --cl-precision auto
+#define PROBE_SATELLITES 4096
+#define PROBE_SUBSTEPS 1000
+// The float kernel is less accurate, so auto only takes it when it beats
+// the double one on the probe by this factor
+#define FLOAT_PROBE_SPEEDUP 1.25
+
+// Event argument of an enqueue, NULL when not profiling
+#define PROFILE_EVENT(events, i) (clProfiling ? &(events)[i] : NULL)
+
+static const int PLATFORM_INDEX = 0;
+static const int DEVICE_INDEX = 0;
+
+static const char *openclErrors[] = {
+    "Success!",
+    "Device not found.",
+    "Device not available",
+    "Compiler not available",
+    "Memory object allocation failure",
+    "Out of resources",
+    "Out of host memory",
+    "Profiling information not available",
+    "Memory copy overlap",
+    "Image format mismatch",
+    "Image format not supported",
+    "Program build failure",
+    "Map failure",
+    "Invalid value",
+    "Invalid device type",
+    "Invalid platform",
+    "Invalid device",
+    "Invalid context",
+    "Invalid queue properties",
+    "Invalid command queue",
+    "Invalid host pointer",
+    "Invalid memory object",
+    "Invalid image format descriptor",
+    "Invalid image size",
+    "Invalid sampler",
+    "Invalid binary",
+    "Invalid build options",
+    "Invalid program",
+    "Invalid program executable",
+    "Invalid kernel name",
+    "Invalid kernel definition",
+    "Invalid kernel",
+    "Invalid argument index",
+    "Invalid argument value",
+    "Invalid argument size",
+    "Invalid kernel arguments",
+    "Invalid work dimension",
+    "Invalid work group size",
+    "Invalid work item size",
+    "Invalid global offset",
+    "Invalid event wait list",
+    "Invalid event",
+    "Invalid operation",
+    "Invalid OpenGL object",
+    "Invalid buffer size",
+    "Invalid mip-map level",
+    "Unknown",
+};
+
+
+static const char *clErrorString(cl_int e)
+{
+   switch (e) {
+      case CL_SUCCESS:                            return openclErrors[ 0];
+      case CL_DEVICE_NOT_FOUND:                   return openclErrors[ 1];
+      case CL_DEVICE_NOT_AVAILABLE:               return openclErrors[ 2];
+      case CL_COMPILER_NOT_AVAILABLE:             return openclErrors[ 3];
+      case CL_MEM_OBJECT_ALLOCATION_FAILURE:      return openclErrors[ 4];
+      case CL_OUT_OF_RESOURCES:                   return openclErrors[ 5];
+      case CL_OUT_OF_HOST_MEMORY:                 return openclErrors[ 6];
+      case CL_PROFILING_INFO_NOT_AVAILABLE:       return openclErrors[ 7];
+      case CL_MEM_COPY_OVERLAP:                   return openclErrors[ 8];
+      case CL_IMAGE_FORMAT_MISMATCH:              return openclErrors[ 9];
+      case CL_IMAGE_FORMAT_NOT_SUPPORTED:         return openclErrors[10];
+      case CL_BUILD_PROGRAM_FAILURE:              return openclErrors[11];
+      case CL_MAP_FAILURE:                        return openclErrors[12];
+      case CL_INVALID_VALUE:                      return openclErrors[13];
+      case CL_INVALID_DEVICE_TYPE:                return openclErrors[14];
+      case CL_INVALID_PLATFORM:                   return openclErrors[15];
+      case CL_INVALID_DEVICE:                     return openclErrors[16];
+      case CL_INVALID_CONTEXT:                    return openclErrors[17];
+      case CL_INVALID_QUEUE_PROPERTIES:           return openclErrors[18];
+      case CL_INVALID_COMMAND_QUEUE:              return openclErrors[19];
+      case CL_INVALID_HOST_PTR:                   return openclErrors[20];
+      case CL_INVALID_MEM_OBJECT:                 return openclErrors[21];
+      case CL_INVALID_IMAGE_FORMAT_DESCRIPTOR:    return openclErrors[22];
+      case CL_INVALID_IMAGE_SIZE:                 return openclErrors[23];
+      case CL_INVALID_SAMPLER:                    return openclErrors[24];
+      case CL_INVALID_BINARY:                     return openclErrors[25];
+      case CL_INVALID_BUILD_OPTIONS:              return openclErrors[26];
+      case CL_INVALID_PROGRAM:                    return openclErrors[27];
+      case CL_INVALID_PROGRAM_EXECUTABLE:         return openclErrors[28];
+      case CL_INVALID_KERNEL_NAME:                return openclErrors[29];
+      case CL_INVALID_KERNEL_DEFINITION:          return openclErrors[30];
+      case CL_INVALID_KERNEL:                     return openclErrors[31];
+      case CL_INVALID_ARG_INDEX:                  return openclErrors[32];
+      case CL_INVALID_ARG_VALUE:                  return openclErrors[33];
+      case CL_INVALID_ARG_SIZE:                   return openclErrors[34];
+      case CL_INVALID_KERNEL_ARGS:                return openclErrors[35];
+      case CL_INVALID_WORK_DIMENSION:             return openclErrors[36];
+      case CL_INVALID_WORK_GROUP_SIZE:            return openclErrors[37];
+      case CL_INVALID_WORK_ITEM_SIZE:             return openclErrors[38];
+      case CL_INVALID_GLOBAL_OFFSET:              return openclErrors[39];
+      case CL_INVALID_EVENT_WAIT_LIST:            return openclErrors[40];
+      case CL_INVALID_EVENT:                      return openclErrors[41];
+      case CL_INVALID_OPERATION:                  return openclErrors[42];
+      case CL_INVALID_GL_OBJECT:                  return openclErrors[43];
+      case CL_INVALID_BUFFER_SIZE:                return openclErrors[44];
+      case CL_INVALID_MIP_LEVEL:                  return openclErrors[45];
+      default:                                    return openclErrors[46];
+   }
+}
+// This function reads in a text file and stores it as a char pointer
+static char *
+readSource(char *kernelPath) {
+    cl_int status;
+    FILE *fp;
+    char *source;
+    long int size;
+    printf("Program file is: %s\n", kernelPath);
+    fp = fopen(kernelPath, "rb");
+    if (!fp) {
+        printf("Could not open kernel file\n");
+        exit(-1);
+    }
+    status = fseek(fp, 0, SEEK_END);
+    if (status != 0) {
+        printf("Error seeking to end of file\n");
+        exit(-1);
+    }
+    size = ftell(fp);
+    if (size < 0) {
+        printf("Error getting file position\n");
+        exit(-1);
+    }
+    rewind(fp);
+    source = (char *)malloc(size + 1);
+    if (source == NULL) {
+        printf("Error allocating space for the kernel source\n");
+        exit(-1);
+    }
+    size_t readBytes = fread(source, 1, size, fp);
+    if ((long int)readBytes != size) {
+        printf("Error reading the kernel file\n");
+        exit(-1);
+    }
+    source[size] = '\0';
+    fclose(fp);
+    return source;
+}
+
+// Informational printing
+static void
+printPlatformInfo(cl_platform_id *platformId, size_t ret_num_platforms) {
+    size_t infoLength = 0;
+    char *infoStr = NULL;
+    cl_int status;
+    for (unsigned int r = 0; r < (unsigned int)ret_num_platforms; ++r) {
+        printf("Platform %d information:\n", r);
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_PROFILE, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Platform profile length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_PROFILE, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Platform profile info error: %s\n", clErrorString(status));
+        }
+        printf("\tProfile: %s\n", infoStr);
+        free(infoStr);
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_VERSION, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Platform version length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_VERSION, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Platform version info error: %s\n", clErrorString(status));
+        }
+        printf("\tVersion: %s\n", infoStr);
+        free(infoStr);
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_NAME, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Platform name length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_NAME, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Platform name info error: %s\n", clErrorString(status));
+        }
+        printf("\tName: %s\n", infoStr);
+        free(infoStr);
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_VENDOR, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Platform vendor info length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_VENDOR, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Platform vendor info error: %s\n", clErrorString(status));
+        }
+        printf("\tVendor: %s\n", infoStr);
+        free(infoStr);
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_EXTENSIONS, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Platform extensions info length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetPlatformInfo(platformId[r], CL_PLATFORM_EXTENSIONS, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Platform extensions info error: %s\n", clErrorString(status));
+        }
+        printf("\tExtensions: %s\n", infoStr);
+        free(infoStr);
+    }
+    printf("\nUsing Platform %d.\n", PLATFORM_INDEX);
+}
+
+// Informational printing
+static void
+printDeviceInfo(cl_device_id *deviceIds, size_t ret_num_devices) {
+    // Print info about the devices
+    size_t infoLength = 0;
+    char *infoStr = NULL;
+    cl_int status;
+
+    for (unsigned int r = 0; r < ret_num_devices; ++r) {
+        printf("Device %d indormation:\n", r);
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_VENDOR, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Device Vendor info length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_VENDOR, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Device Vendor info error: %s\n", clErrorString(status));
+        }
+        printf("\tVendor: %s\n", infoStr);
+        free(infoStr);
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_NAME, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Device name info length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_NAME, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Device name info error: %s\n", clErrorString(status));
+        }
+        printf("\tName: %s\n", infoStr);
+        free(infoStr);
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_VERSION, 0, NULL, &infoLength);
+        if (status != CL_SUCCESS) {
+            printf("Device version info length error: %s\n", clErrorString(status));
+        }
+        infoStr = malloc((infoLength) * sizeof(char));
+        status = clGetDeviceInfo(deviceIds[r], CL_DEVICE_VERSION, infoLength, infoStr, NULL);
+        if (status != CL_SUCCESS) {
+            printf("Device version info error: %s\n", clErrorString(status));
+        }
+        printf("\tVersion: %s\n", infoStr);
+        free(infoStr);
+        cl_device_fp_config fp64 = 0;
+        cl_int s = clGetDeviceInfo(deviceIds[r], CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(fp64), &fp64, NULL);
+        if (s == CL_SUCCESS && fp64 == 0) {
+            printf("\tDouble precision: NOT supported\n");
+        } else if (s == CL_SUCCESS) {
+            printf("\tDouble precision: supported\n");
+        }
+    }
+    printf("\nUsing Device %d.\n", DEVICE_INDEX);
+}
+
+
+
+
+// ======= Run graphics on OpenCL =======
+// Global variables to store buffer sizes (computed once during initialization)
+
+// Compiles parallel.cl with the given options, aborts on errors
+static cl_program build_program(const char *options) {
+    cl_int status;
+    const char *source = programSource;
+    cl_program built = clCreateProgramWithSource(context, 1, &source, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Program creation error: %s", clErrorString(status));
+    }
+
+    // Program compiling
+    status = clBuildProgram(built, 1, &device, options, NULL, NULL);
+    if (status != CL_SUCCESS) {
+        printf("OpenCL build error: %s\n", clErrorString(status));
+        // Fetch build errors if there were some.
+        if (status == CL_BUILD_PROGRAM_FAILURE) {
+            size_t infoLength = 0;
+            cl_int cl_build_status = clGetProgramBuildInfo(
+                built, device, CL_PROGRAM_BUILD_LOG, 0, 0, &infoLength);
+            if (cl_build_status != CL_SUCCESS) {
+                printf("Build log length fetch error: %s\n", clErrorString(cl_build_status));
+            }
+            char *infoStr = malloc(infoLength * sizeof(char));
+            cl_build_status = clGetProgramBuildInfo(
+                built, device, CL_PROGRAM_BUILD_LOG, infoLength, infoStr, 0);
+            if (cl_build_status != CL_SUCCESS) {
+                printf("Build log fetch error: %s\n", clErrorString(cl_build_status));
+            }
+
+            printf("OpenCL build log:\n %s", infoStr);
+            free(infoStr);
+        }
+        abort();
+    }
+    return built;
+}
+
+static void ocl_init(void) {
+    // Start the OpenCL initialization
+    cl_int status;  // Use this to check the output of each API call
+
+    // Size of satellite data array (all satellites)
+    satelliteBytes = sizeof(satellite) * satelliteCount;
+    // Calculate memory sizes for OpenCL buffers
+    physParamsBytes = sizeof(PhysParams);
+    // Size of parameters struct (constants like mouse position, radii, etc.)
+    graphicParamsBytes = sizeof(GraphicParams);
+    // Size of pixel buffer (RGBA format: 4 bytes per pixel)
+    pixelBytes = sizeof(color_u8) * windowWidth * windowHeight;
+
+
+    // Get available OpenCL platforms
+    cl_uint ret_num_platforms;
+    status = clGetPlatformIDs(0, NULL, &ret_num_platforms);
+    if (status != CL_SUCCESS) {
+        printf("Error getting the number of platforms: %s", clErrorString(status));
+    }
+    cl_platform_id *platformId = malloc(sizeof(cl_platform_id) * ret_num_platforms);
+    status = clGetPlatformIDs(ret_num_platforms, platformId, NULL);
+    if (status != CL_SUCCESS) {
+        printf("Error getting the platforms: %s", clErrorString(status));
+    }
+
+    // Print info about the platform. Not needed for functionality,
+    // but nice to see in order to confirm your OpenCL installation
+    printPlatformInfo(platformId, ret_num_platforms);
+
+    // Get available devices
+    cl_uint ret_num_devices = 0;
+    status = clGetDeviceIDs(
+        platformId[PLATFORM_INDEX], CL_DEVICE_TYPE_ALL, 0, NULL, &ret_num_devices);
+    if (status != CL_SUCCESS) {
+        printf("Error getting the number of devices: %s", clErrorString(status));
+    }
+    cl_device_id *deviceIds = malloc((ret_num_devices) * sizeof(cl_device_id));
+    status = clGetDeviceIDs(
+        platformId[PLATFORM_INDEX], CL_DEVICE_TYPE_ALL, ret_num_devices, deviceIds, &ret_num_devices);
+    if (status != CL_SUCCESS) {
+        printf("Error getting device ids: %s", clErrorString(status));
+    }
+
+    // Again, this only prints nice-to-know information
+    printDeviceInfo(deviceIds, ret_num_devices);
+
+    context = clCreateContext(NULL, 1, &(deviceIds[DEVICE_INDEX]), NULL, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Context creation error: %s\n", clErrorString(status));
+    }
+
+    // In order command queue
+    // Using the 1.2 clCreateCommandQueue API since it's bit simpler,
+    // this was later deprecated in OpenCL 2.0
+    commandQueue = clCreateCommandQueue(context, deviceIds[DEVICE_INDEX],
+                                        clProfiling ? CL_QUEUE_PROFILING_ENABLE : 0, &status);
+    if (status != CL_SUCCESS) {
+        printf("Command queue creation error: %s", clErrorString(status));
+    }
+
+    device = deviceIds[DEVICE_INDEX];
+    cl_device_fp_config fp64 = 0;
+    status = clGetDeviceInfo(device, CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(fp64), &fp64, NULL);
+    deviceFp64 = status == CL_SUCCESS && fp64 != 0;
+
+    // Make kernel string into a program. The double physics kernel is only
+    // compiled when the device has fp64.
+    programSource = readSource("parallel.cl");
+    program = build_program(deviceFp64 ? "-cl-fast-relaxed-math -cl-mad-enable -DHAVE_FP64"
+                                       : "-cl-fast-relaxed-math -cl-mad-enable");
+
+
+    // Create the vector addition kernel
+    kernelRender = clCreateKernel(program, "graphics_render", &status);
+    if (status != CL_SUCCESS) {
+        printf("Kernel (graphics_render) creation error: %s\n", clErrorString(status));
+    }
+
+    // One work-group per tile, halved until the device takes the group
+    if (graphicsTileSize > 0) {
+        kernelRenderTiled = clCreateKernel(program, "graphics_render_tiled", &status);
+        if (status != CL_SUCCESS) {
+            printf("Kernel (graphics_render_tiled) creation error: %s\n", clErrorString(status));
+        }
+        size_t maxGroup = 1;
+        clGetKernelWorkGroupInfo(kernelRenderTiled, device, CL_KERNEL_WORK_GROUP_SIZE,
+                                 sizeof(maxGroup), &maxGroup, NULL);
+        tileSize = (size_t)graphicsTileSize;
+        while (tileSize > 1 && tileSize * tileSize > maxGroup) {
+            tileSize /= 2;
+        }
+        if (tileSize != (size_t)graphicsTileSize) {
+            printf("OpenCL tiles of %zux%zu pixels, the device takes at most %zu work-items per group\n",
+                   tileSize, tileSize, maxGroup);
+        }
+    }
+
+    // Create bufSats: satellites must be read-write now (physics writes to it)
+    // This buffer will store the array of satellite structures on the device
+    bufSats = clCreateBuffer(context, CL_MEM_READ_WRITE, satelliteBytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Satellites buffer creation error: %s", clErrorString(status));
+    }
+
+    bufEvaluations = clCreateBuffer(context, CL_MEM_WRITE_ONLY,
+                                    satelliteBytes / sizeof(satellite) * sizeof(cl_uint), NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Evaluations buffer creation error: %s", clErrorString(status));
+    }
+    hostEvaluations = (cl_uint*)malloc(satelliteBytes / sizeof(satellite) * sizeof(cl_uint));
+
+    // physics params buffer
+    bufPhysParams = clCreateBuffer(context, CL_MEM_READ_ONLY, physParamsBytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Physics params buffer creation error: %s", clErrorString(status));
+    }
+
+    // Create bufGraphicParams: Read-only buffer for parameters
+    // This buffer holds constants like mouse position, radii, window dimensions, etc.
+    bufGraphicParams = clCreateBuffer(context, CL_MEM_READ_ONLY, graphicParamsBytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Graphic params buffer creation error: %s", clErrorString(status));
+    }
+
+    // Create bufPixels: Write-only buffer for output pixels
+    // The kernel will write rendered RGBA pixel data into this buffer
+    bufPixels = clCreateBuffer(context, CL_MEM_WRITE_ONLY, pixelBytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Pixels buffer creation error: %s", clErrorString(status));
+    }
+
+    free(deviceIds);
+    free(platformId);
+}
+
+// Reads the timestamps of count finished commands starting from profile
+// first, one CSV line per command relative to the first queued time
+static void record_profile(int first, int count, cl_event *events, unsigned int call) {
+    cl_ulong origin = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!events[i]) {
+            continue; // The enqueue failed
+        }
+        cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+        cl_int status = clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_QUEUED, sizeof(queued), &queued, NULL);
+        status |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_SUBMIT, sizeof(submit), &submit, NULL);
+        status |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL);
+        status |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL);
+        clReleaseEvent(events[i]);
+        events[i] = NULL;
+        if (status != CL_SUCCESS) {
+            printf("%s profiling info error\n", profiles[first + i].name);
+            continue;
+        }
+        if (!origin) {
+            origin = queued;
+        }
+        timingRecord(&profiles[first + i].wait, start - queued);
+        timingRecord(&profiles[first + i].run, end - start);
+        if (profileFile) {
+            fprintf(profileFile, "%u,%s,%llu,%llu,%llu,%llu\n", call, profiles[first + i].name,
+                    (unsigned long long)(queued - origin), (unsigned long long)(submit - origin),
+                    (unsigned long long)(start - origin), (unsigned long long)(end - origin));
+        }
+    }
+}
+
+int openclEnableProfiling(const char *csvPath) {
+    clProfiling = 1;
+    if (csvPath && csvPath[0]) {
+        profileFile = fopen(csvPath, "w");
+        if (!profileFile) {
+            printf("Cannot create profile file: %s\n", csvPath);
+            return -1;
+        }
+        fprintf(profileFile, "call,command,queued_ns,submit_ns,start_ns,end_ns\n");
+    }
+    printf("Profiling OpenCL commands%s%s\n", profileFile ? " to " : "", profileFile ? csvPath : "");
+    return 0;
+}
+
+void openclPrintProfile(void) {
+    if (!clProfiling) {
+        return;
+    }
+    printf("OpenCL commands over %u physics and %u graphics calls (queued -> start, start -> end):\n",
+           physicsCalls, graphicsCalls);
+    for (int i = 0; i < PROFILE_COMMANDS; ++i) {
+        if (profiles[i].run.count == 0) {
+            continue;
+        }
+        printf("%s\n", profiles[i].name);
+        timingPrint("  wait", &profiles[i].wait);
+        timingPrint("  run", &profiles[i].run);
+    }
+}
+
+void openclPrintProfileJson(FILE *f) {
+    fprintf(f, "{");
+    int printed = 0;
+    for (int i = 0; i < PROFILE_COMMANDS; ++i) {
+        if (profiles[i].run.count == 0) {
+            continue;
+        }
+        fprintf(f, "%s\"%s\":{", printed++ ? "," : "", profiles[i].name);
+        timingPrintJson(f, "wait", &profiles[i].wait);
+        fprintf(f, ",");
+        timingPrintJson(f, "run", &profiles[i].run);
+        fprintf(f, "}");
+    }
+    fprintf(f, "}");
+}
+
+// Grows bufSats and bufEvaluations when a call has more satellites than
+// they were created for
+static void reserve_satellites_on_ocl(size_t bytes) {
+    if (bytes <= satelliteBytes) {
+        return;
+    }
+    cl_int status;
+    clReleaseMemObject(bufSats);
+    bufSats = clCreateBuffer(context, CL_MEM_READ_WRITE, bytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Satellites buffer creation error: %s\n", clErrorString(status));
+    }
+    size_t evaluationBytes = bytes / sizeof(satellite) * sizeof(cl_uint);
+    clReleaseMemObject(bufEvaluations);
+    bufEvaluations = clCreateBuffer(context, CL_MEM_WRITE_ONLY, evaluationBytes, NULL, &status);
+    if (status != CL_SUCCESS) {
+        printf("Evaluations buffer creation error: %s\n", clErrorString(status));
+    }
+    free(hostEvaluations);
+    hostEvaluations = (cl_uint*)malloc(evaluationBytes);
+    satelliteBytes = bytes;
+}
+
+static void run_physics_on_ocl(satellite* satsHost, const PhysParams* physParams)
+{
+    cl_int status; // Use this to check the output of each API call
+    size_t bytes = sizeof(satellite) * physParams->satCount;
+    reserve_satellites_on_ocl(bytes);
+    cl_event events[4] = {NULL, NULL, NULL, NULL};
+    uint64_t uploadStart = timingNow();
+
+    //============= upload =============
+    status = clEnqueueWriteBuffer(commandQueue, bufSats, CL_FALSE, 0, bytes, satsHost, 0, NULL, PROFILE_EVENT(events, 0));
+    if (status != CL_SUCCESS) {
+        printf("bufSats (physics) write error: %s\n", clErrorString(status));
+    }
+
+    // Upload physics params (blocking is fine—small)
+    status = clEnqueueWriteBuffer(commandQueue, bufPhysParams, CL_TRUE, 0, physParamsBytes, physParams, 0, NULL, PROFILE_EVENT(events, 1));
+    if (status != CL_SUCCESS) {
+        printf("bufPhysParams (physics) write error: %s\n", clErrorString(status));
+    }
+
+    uint64_t launchStart = timingNow();
+    traceSpan("physics upload", "opencl", TRACE_TID_MAIN, uploadStart, launchStart, NULL, 0);
+
+    //============= set args =============
+    status = clSetKernelArg(kernelCompute, 0, sizeof(cl_mem), &bufSats);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelCompute arg 0: %s\n", clErrorString(status));
+    }
+
+    status = clSetKernelArg(kernelCompute, 1, sizeof(cl_mem), &bufPhysParams);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelCompute arg 1: %s\n", clErrorString(status));
+    }
+
+    status = clSetKernelArg(kernelCompute, 2, sizeof(cl_mem), &bufEvaluations);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelCompute arg 2: %s\n", clErrorString(status));
+    }
+
+    //============= launch =============
+    // Global size = number of satellites
+    size_t N = physParams->satCount;
+    size_t globalWorkSize = (localSize == 0) ? N : ((N + localSize - 1) / localSize) * localSize;
+    const size_t* localWorkSize = (localSize == 0) ? NULL : &localSize;
+
+    status = clEnqueueNDRangeKernel(commandQueue, kernelCompute, 1, NULL, &globalWorkSize, localWorkSize, 0, NULL, PROFILE_EVENT(events, 2));
+    if (status != CL_SUCCESS) {
+        printf("kernelCompute enqueue error: %s\n", clErrorString(status));
+    }
+
+    uint64_t readStart = timingNow();
+    traceSpan("physics kernel enqueue", "opencl", TRACE_TID_MAIN, launchStart, readStart, NULL, 0);
+
+    //============= read back =============
+    // The in-order queue finishes this before the blocking read below
+    if (physParams->adaptiveEta > 0.0f) {
+        status = clEnqueueReadBuffer(commandQueue, bufEvaluations, CL_FALSE, 0,
+                                     sizeof(cl_uint) * N, hostEvaluations, 0, NULL, NULL);
+        if (status != CL_SUCCESS) {
+            printf("bufEvaluations read error: %s\n", clErrorString(status));
+        }
+    }
+
+    // Get updated satellites back to host so CPU copy stays in sync
+    status = clEnqueueReadBuffer(commandQueue, bufSats, CL_TRUE, 0, bytes, satsHost, 0, NULL, PROFILE_EVENT(events, 3));
+    if (status != CL_SUCCESS) {
+        printf("bufSats read (physics) error: %s\n", clErrorString(status));
+    }
+
+    // The blocking read finished every command of this call
+    traceSpan("physics read (blocking)", "opencl", TRACE_TID_MAIN, readStart, timingNow(), NULL, 0);
+    if (physParams->adaptiveEta > 0.0f) {
+        long long evaluations = 0;
+        for (size_t k = 0; k < N; ++k) {
+            evaluations += hostEvaluations[k];
+        }
+        frameForceEvaluations = evaluations;
+    } else {
+        frameForceEvaluations = (long long)N *
+            integratorForceEvaluations(physParams->integrator, physParams->substeps);
+    }
+    physicsCalls++;
+    if (clProfiling) {
+        record_profile(PROFILE_PHYSICS_WRITE_SATELLITES, 4, events, physicsCalls);
+    }
+}
+
+static void run_graphics_on_ocl(const satellite* satsHost, const GraphicParams* graphicParams, color_u8* outPixels, int stride) {
+    cl_int status;  // Use this to check the output of each API call
+    size_t bytes = sizeof(satellite) * graphicParams->satCount;
+    reserve_satellites_on_ocl(bytes);
+    cl_event events[4] = {NULL, NULL, NULL, NULL};
+    uint64_t uploadStart = timingNow();
+
+    //============= upload =============
+    // Write satellite data to device buffer A (non-blocking)
+    // Transfers the array of satellite structures from host memory (A) to GPU
+    status = clEnqueueWriteBuffer(commandQueue, bufSats, CL_FALSE, 0, bytes, satsHost, 0, NULL, PROFILE_EVENT(events, 0));
+    if (status != CL_SUCCESS) {
+        printf("bufSats (graphic) write error: %s", clErrorString(status));
+    }
+
+    // Write parameters to device buffer B (non-blocking)
+    // Transfers constants (mouse position, radii, dimensions) from host memory (B) to GPU
+    status = clEnqueueWriteBuffer(commandQueue, bufGraphicParams, CL_FALSE, 0, graphicParamsBytes, graphicParams, 0, NULL, PROFILE_EVENT(events, 1));
+    if (status != CL_SUCCESS) {
+        printf("bufGraphicParams (graphic) write error: %s", clErrorString(status));
+    }
+
+    uint64_t launchStart = timingNow();
+    traceSpan("graphics upload", "opencl", TRACE_TID_MAIN, uploadStart, launchStart, NULL, 0);
+
+    //============= set args =============
+    // Associate the input and output buffers with the kernel
+    cl_kernel kernel = kernelRenderTiled ? kernelRenderTiled : kernelRender;
+    status = clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufSats);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelRender arg 0: %s", clErrorString(status));
+    }
+    status = clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufGraphicParams);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelRender arg 1: %s", clErrorString(status));
+    }
+    status = clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufPixels);
+    if (status != CL_SUCCESS) {
+        printf("Error setting kernelRender arg 2: %s", clErrorString(status));
+    }
+
+    //============= launch =============
+    // Calculate total number of pixels to process
+    size_t totalPixels = (size_t)graphicParams->width * (size_t)graphicParams->height;
+
+    // Arrays to hold the global and local work sizes for the kernel
+    size_t globalWorkSize[1];
+    size_t localWorkSize[1];
+
+    if (kernelRenderTiled) {
+        // 2D range of whole tiles, --local does not apply
+        size_t tileGlobal[2] = {
+            (graphicParams->width + tileSize - 1) / tileSize * tileSize,
+            (graphicParams->height + tileSize - 1) / tileSize * tileSize};
+        size_t tileLocal[2] = {tileSize, tileSize};
+        status = clEnqueueNDRangeKernel(commandQueue, kernelRenderTiled, 2,
+                                        NULL, tileGlobal, tileLocal,
+                                        0, NULL, PROFILE_EVENT(events, 2));
+    } else if (localSize == 0) {
+        // No work-group size specified - let OpenCL runtime choose optimal size
+        globalWorkSize[0] = totalPixels;
+
+        // Enqueue kernel with automatic work-group size selection
+        // The NULL parameter for local work size lets OpenCL decide
+        status = clEnqueueNDRangeKernel(commandQueue, kernelRender, 1,
+                                        NULL, globalWorkSize, NULL, 0, NULL, PROFILE_EVENT(events, 2));
+
+    } else {
+        // Fixed work-group size specified by user
+        // Global size must be a multiple of local size, so we round up
+        localWorkSize[0]  = localSize;// Local work-group size
+        globalWorkSize[0] = ((totalPixels + localSize - 1) / localSize) * localSize;  // Round up totalPixels to nearest multiple of localSize
+
+        // Enqueue kernel with explicit work-group size
+        // This allows testing different work-group sizes for performance tuning
+        status = clEnqueueNDRangeKernel(commandQueue, kernelRender, 1,
+                                        NULL, globalWorkSize, localWorkSize,
+                                        0, NULL, PROFILE_EVENT(events, 2));
+    }
+    if (status != CL_SUCCESS) {
+         printf("kernelRender enqueue error: %s\n", clErrorString(status));
+    }
+
+
+    uint64_t readStart = timingNow();
+    traceSpan("graphics kernel enqueue", "opencl", TRACE_TID_MAIN, launchStart, readStart, NULL, 0);
+
+    //============= read back =============
+    // Read rendered pixel data from device buffer C (blocking)
+    // Transfers the RGBA pixel buffer from GPU back to host memory (C) for display
+    if (stride == graphicParams->width) {
+        status = clEnqueueReadBuffer(commandQueue, bufPixels, CL_TRUE, 0, pixelBytes, outPixels, 0, NULL, PROFILE_EVENT(events, 3));
+    } else {
+        // Straight into the rows of the window surface, which are stride pixels apart
+        size_t origin[3] = {0, 0, 0};
+        size_t region[3] = {sizeof(color_u8) * graphicParams->width, graphicParams->height, 1};
+        status = clEnqueueReadBufferRect(commandQueue, bufPixels, CL_TRUE, origin, origin, region,
+                                         sizeof(color_u8) * graphicParams->width, 0,
+                                         sizeof(color_u8) * stride, 0,
+                                         outPixels, 0, NULL, PROFILE_EVENT(events, 3));
+    }
+    if (status != CL_SUCCESS) {
+        printf("bufPixels (graphic) read error%s", clErrorString(status));
+    }
+
+    traceSpan("graphics read (blocking)", "opencl", TRACE_TID_MAIN, readStart, timingNow(), NULL, 0);
+    graphicsCalls++;
+    if (clProfiling) {
+        record_profile(PROFILE_GRAPHICS_WRITE_SATELLITES, 4, events, graphicsCalls);
+    }
+}
+
+static void ocl_destroy(void) {
+    if (profileFile) {
+        fclose(profileFile);
+        profileFile = NULL;
+    }
+    // Release all OpenCL objects that we created ourselves
+    clReleaseMemObject(bufSats);
+    clReleaseMemObject(bufPhysParams);
+    clReleaseMemObject(bufEvaluations);
+    free(hostEvaluations);
+    hostEvaluations = NULL;
+    clReleaseMemObject(bufGraphicParams);
+    clReleaseMemObject(bufPixels);
+    if (kernelComputeDouble) {
+        clReleaseKernel(kernelComputeDouble);
+    }
+    if (kernelComputeFloat) {
+        clReleaseKernel(kernelComputeFloat);
+    }
+    if (programFloat) {
+        clReleaseProgram(programFloat);
+    }
+    kernelCompute = kernelComputeDouble = kernelComputeFloat = NULL;
+    programFloat = NULL;
+    clReleaseKernel(kernelRender);
+    if (kernelRenderTiled) {
+        clReleaseKernel(kernelRenderTiled);
+        kernelRenderTiled = NULL;
+    }
+    clReleaseProgram(program);
+    free(programSource);
+    programSource = NULL;
+    clReleaseCommandQueue(commandQueue);
+    clReleaseContext(context);
+}
+
+
+// The physics and graphics engines share one context, the first user
+// creates it and the last one releases it
+static void openclInit(void) {
+    if (oclUsers++ == 0) {
+        ocl_init(); // Initialize OpenCL environment
+    }
+}
+
+static void openclDestroy(void) {
+    if (--oclUsers == 0) {
+        ocl_destroy();
+    }
+}
+
+/////////////////////////////
+// ¤¤ Physics computing ¤¤ //
+/////////////////////////////
+int openclSetPrecision(const char *name) {
+    for (int i = 0; i < (int)(sizeof(precisionNames) / sizeof(precisionNames[0])); ++i) {
+        if (!strcmp(precisionNames[i], name)) {
+            clPrecision = i;
+            return 0;
+        }
+    }
+    printf("Unknown OpenCL precision: %s (auto, double, float)\n", name);
+    return -1;
+}
+
+double openclPhysicsTolerance(void) {
+    return floatPhysics ? FLOAT_PHYSICS_TOLERANCE : 0.0;
+}
+
+static cl_kernel create_physics_kernel(cl_program from, const char *name) {
+    cl_int status;
+    cl_kernel kernel = clCreateKernel(from, name, &status);
+    if (status != CL_SUCCESS) {
+        printf("Kernel (%s) creation error: %s\n", name, clErrorString(status));
+    }
+    return kernel;
+}
+
+// Nanoseconds of one run of kernel over satellites on circular orbits
+// around the window center, after a first run that warms it up
+static uint64_t time_physics_kernel(cl_kernel kernel, const satellite *probe) {
+    PhysParams probeParams = {
+        .substeps  = PROBE_SUBSTEPS,
+        .gravity   = GRAVITY,
+        .dt        = DELTATIME,
+        .mouseX    = windowWidth / 2,
+        .mouseY    = windowHeight / 2,
+        .satCount  = PROBE_SATELLITES,
+        .integrator = integrator,
+        .adaptiveEta = 0.0f
+    };
+    size_t bytes = sizeof(satellite) * PROBE_SATELLITES;
+    size_t globalWorkSize = PROBE_SATELLITES;
+    reserve_satellites_on_ocl(bytes);
+    cl_int status = clEnqueueWriteBuffer(commandQueue, bufPhysParams, CL_TRUE, 0, physParamsBytes, &probeParams, 0, NULL, NULL);
+    status |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufSats);
+    status |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufPhysParams);
+    status |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufEvaluations);
+    uint64_t elapsed = 0;
+    for (int run = 0; run < 2 && status == CL_SUCCESS; ++run) {
+        status = clEnqueueWriteBuffer(commandQueue, bufSats, CL_TRUE, 0, bytes, probe, 0, NULL, NULL);
+        uint64_t start = timingNow();
+        status |= clEnqueueNDRangeKernel(commandQueue, kernel, 1, NULL, &globalWorkSize, NULL, 0, NULL, NULL);
+        status |= clFinish(commandQueue);
+        elapsed = timingNow() - start;
+    }
+    if (status != CL_SUCCESS) {
+        printf("Physics kernel probe error: %s\n", clErrorString(status));
+        return UINT64_MAX;
+    }
+    return elapsed;
+}
+
+// Picks physics_compute or physics_compute_float (--cl-precision)
+static void select_physics_kernel(void) {
+    int precision = clPrecision;
+    if (!deviceFp64 && precision != CL_PRECISION_FLOAT) {
+        if (precision == CL_PRECISION_DOUBLE) {
+            printf("The device has no fp64, ignoring --cl-precision double\n");
+        }
+        precision = CL_PRECISION_FLOAT;
+    }
+    if (precision != CL_PRECISION_FLOAT) {
+        kernelComputeDouble = create_physics_kernel(program, "physics_compute");
+    }
+    if (precision != CL_PRECISION_DOUBLE) {
+        // Strict float math, the two-float sums depend on the exact rounding
+        programFloat = build_program("-DPHYSICS_FLOAT");
+        kernelComputeFloat = create_physics_kernel(programFloat, "physics_compute_float");
+    }
+
+    if (precision == CL_PRECISION_AUTO && (!kernelComputeDouble || !kernelComputeFloat)) {
+        // Nothing to compare, take the kernel that was created
+        precision = kernelComputeFloat ? CL_PRECISION_FLOAT : CL_PRECISION_DOUBLE;
+    } else if (precision == CL_PRECISION_AUTO) {
+        satellite *probe = (satellite*)calloc(PROBE_SATELLITES, sizeof(satellite));
+        if (!probe) {
+            printf("Out of memory for the physics probe\n");
+            exit(-1);
+        }
+        for (int i = 0; i < PROBE_SATELLITES; ++i) {
+            float radius = 50.0f + (float)(i % 256);
+            probe[i].position.x = windowWidth / 2 + radius;
+            probe[i].position.y = windowHeight / 2;
+            probe[i].velocity.y = sqrtf(GRAVITY / radius);
+        }
+        uint64_t doubleTime = time_physics_kernel(kernelComputeDouble, probe);
+        uint64_t floatTime = time_physics_kernel(kernelComputeFloat, probe);
+        free(probe);
+        if (doubleTime != UINT64_MAX && floatTime != UINT64_MAX) {
+            printf("Physics kernel probe: double %.3f ms, float %.3f ms\n",
+                   doubleTime / 1e6, floatTime / 1e6);
+        }
+        // A failed probe counts as UINT64_MAX, so the other kernel wins
+        precision = (double)floatTime * FLOAT_PROBE_SPEEDUP < (double)doubleTime ?
+                    CL_PRECISION_FLOAT : CL_PRECISION_DOUBLE;
+    }
+    floatPhysics = precision == CL_PRECISION_FLOAT;
+    kernelCompute = floatPhysics ? kernelComputeFloat : kernelComputeDouble;
+    printf("OpenCL physics in %s (fp64 %ssupported)\n",
+           floatPhysics ? "two-float single precision" : "double precision",
+           deviceFp64 ? "" : "not ");
+}
+
+static void openclPhysicsInit(void) {
+    openclInit();
+    select_physics_kernel();
+}
+
+static void openclPhysicsRun(satellite *sats, int count, int mouseX, int mouseY) {
+    // Build PhysParams from your engine constants / input
+    PhysParams physP = {
+        .substeps  = physicsUpdatesPerFrame,
+        .gravity   = GRAVITY,
+        .dt        = DELTATIME,
+        .mouseX    = mouseX,
+        .mouseY    = mouseY,
+        .satCount  = count,
+        .integrator = integrator,
+        .adaptiveEta = (float)adaptiveEta
+    };
+
+    // Execute the OpenCL physics kernel
+    // Inputs: satellite array, parameters struct
+    // sats[] with new values
+    run_physics_on_ocl(sats, &physP);
+}
+
+/////////////////////////////
+// ¤¤ Graphic rendering ¤¤ //
+/////////////////////////////
+// This function prepares parameters and delegates rendering to the GPU
+static void openclGraphicsRun(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out, int stride) {
+    // Pack all rendering parameters into a single struct for efficient GPU transfer
+    GraphicParams graphP = {
+        .width = windowWidth,               // Window width in pixels
+        .height = windowHeight,             // Window height in pixels
+        .mouseX = mouseX,                   // Current mouse X position (black hole center)
+        .mouseY = mouseY,                   // Current mouse Y position (black hole center)
+        .blackHoleRadius2 = BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS,  // Pre-squared for fast comparison
+        .satelliteRadius2 = SATELLITE_RADIUS * SATELLITE_RADIUS,    // Pre-squared for hit detection
+        .satCount = count                   // Total number of satellites to render
+    };
+
+    // Execute the OpenCL graphics kernel
+    // Inputs: satellite array, parameters struct
+    // Output: rendered pixel buffer
+    run_graphics_on_ocl(sats, &graphP, out, stride);
+}
+
+const PhysicsEngine openclPhysics = {
+    .name = "opencl",
+    .init = openclPhysicsInit,
+    .destroy = openclDestroy,
+    .run = openclPhysicsRun
+};
+
+const GraphicsEngine openclGraphics = {
+    .name = "opencl",
+    .init = openclInit,
+    .destroy = openclDestroy,
+    .run = openclGraphicsRun
+};
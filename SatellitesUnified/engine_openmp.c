@@ -0,0 +1,417 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Physics and Graphic both on CPU with omp    ¤¤               //
+//                                                                    //
+//    Same code as Satellites2omp (physics from Satellites1kernel)    //
+//    with the omp pragmas enabled                                    //
+////////////////////////////////////////////////////////////////////////
+
+#include "integrator.h"
+#include "satellites.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <math.h> // INFINITY
+#include <string.h> // memcpy
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Pixels between fresh distances of --incremental, 0 computes every
+// distance from scratch
+int incrementalReseed = 0;
+
+// Distances, next distances and steps of --incremental, one block per
+// OpenMP thread. Kept between frames so that it is only reallocated when
+// the satellites or the threads grow.
+static float *incrementalScratch = NULL;
+static size_t incrementalCapacity = 0;
+
+static void reserveIncremental(size_t floats){
+   if (floats <= incrementalCapacity) {
+      return;
+   }
+   alignedFree(incrementalScratch);
+   incrementalScratch = (float*)alignedAlloc(sizeof(float) * floats);
+   if (!incrementalScratch) {
+      printf("Out of memory for %zu satellite distances\n", floats);
+      exit(-1);
+   }
+   incrementalCapacity = floats;
+}
+
+// Sort key of a satellite at squared distance distanceSquared. The bits
+// of a non-negative float grow with its value, so the smallest key is the
+// closest satellite, and the first one of equally close satellites.
+static inline uint64_t nearestKey(float distanceSquared, int j){
+   uint32_t bits;
+   memcpy(&bits, &distanceSquared, sizeof(bits));
+   return ((uint64_t)bits << 32) | (uint32_t)j;
+}
+
+// Physics with --adaptive steps. The satellites close to the black hole
+// take many more steps than the others, so they are handed out one by one.
+static void openmpAdaptiveRun(satellite *sats, int count, int mouseX, int mouseY){
+   long long evaluations = 0;
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel reduction(+:evaluations)
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkSatellites = 0;
+   int i;
+   #pragma omp for schedule(dynamic, 1) nowait
+   for (i = 0; i < count; ++i) {
+      chunkSatellites++;
+      doublevector tmpPosition = {.x = sats[i].position.x, .y = sats[i].position.y};
+      doublevector tmpVelocity = {.x = sats[i].velocity.x, .y = sats[i].velocity.y};
+      evaluations += integrateSatelliteAdaptive(&tmpPosition, &tmpVelocity, mouseX, mouseY,
+                                                adaptiveEta, physicsUpdatesPerFrame,
+                                                integrator);
+      sats[i].position.x = tmpPosition.x;
+      sats[i].position.y = tmpPosition.y;
+      sats[i].velocity.x = tmpVelocity.x;
+      sats[i].velocity.y = tmpVelocity.y;
+   }
+   if (chunkStart) {
+      traceSpan("physics chunk", "openmp", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "satellites", chunkSatellites);
+   }
+   }
+   frameForceEvaluations = evaluations;
+}
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+// Moves the satellites based on gravity
+// The loops are swapped compared to the sequential engine, so that every
+// thread walks all the substeps of its own satellites.
+static void openmpPhysicsRun(satellite *sats, int count, int mouseX, int mouseY){
+
+   if (adaptiveEta > 0.0) {
+      openmpAdaptiveRun(sats, count, mouseX, mouseY);
+      return;
+   }
+   frameForceEvaluations = count * integratorForceEvaluations(integrator, physicsUpdatesPerFrame);
+
+   int tmpMousePosX = mouseX;
+   int tmpMousePosY = mouseY;
+
+   // Physics iteration loop
+   // Every thread records its chunk to the trace, without a barrier at the
+   // end of the loop so the spans show the load imbalance
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkSatellites = 0;
+   int i;
+   #pragma omp for schedule(static) nowait
+   for (i = 0; i < count; ++i)
+   { // Physics satellite loop
+       chunkSatellites++;
+       // double precision required for accumulation inside this routine,
+       // but float storage is ok outside these loops.
+       // The state of one satellite stays in registers for all substeps.
+       doublevector tmpPosition = {.x = sats[i].position.x, .y = sats[i].position.y};
+       doublevector tmpVelocity = {.x = sats[i].velocity.x, .y = sats[i].velocity.y};
+
+       if (integrator != INTEGRATOR_EULER) {
+          integrateSatellite(&tmpPosition, &tmpVelocity, tmpMousePosX, tmpMousePosY,
+                             physicsUpdatesPerFrame, integrator);
+       } else {
+          int physicsUpdateIndex;
+          for (physicsUpdateIndex = 0;
+              physicsUpdateIndex < physicsUpdatesPerFrame;
+              ++physicsUpdateIndex) {
+            // Distance to the blackhole (bit ugly code because C-struct cannot have member functions)
+            doublevector positionToBlackHole = {.x = tmpPosition.x -
+               tmpMousePosX, .y = tmpPosition.y - tmpMousePosY};
+            double distToBlackHoleSquared =
+               positionToBlackHole.x * positionToBlackHole.x +
+               positionToBlackHole.y * positionToBlackHole.y;
+            double distToBlackHole = sqrt(distToBlackHoleSquared);
+
+            // Gravity force
+            doublevector normalizedDirection = {
+               .x = positionToBlackHole.x / distToBlackHole,
+               .y = positionToBlackHole.y / distToBlackHole};
+            double accumulation = GRAVITY / distToBlackHoleSquared;
+
+            // Delta time is used to make velocity same despite different FPS
+            // Update velocity based on force
+            tmpVelocity.x -= accumulation * normalizedDirection.x *
+               DELTATIME / physicsUpdatesPerFrame;
+            tmpVelocity.y -= accumulation * normalizedDirection.y *
+               DELTATIME / physicsUpdatesPerFrame;
+
+            tmpPosition.x +=
+               tmpVelocity.x * DELTATIME / physicsUpdatesPerFrame;
+            tmpPosition.y +=
+               tmpVelocity.y * DELTATIME / physicsUpdatesPerFrame;
+         }
+
+       }
+
+      // copy back the float storage.
+      sats[i].position.x = tmpPosition.x;
+      sats[i].position.y = tmpPosition.y;
+      sats[i].velocity.x = tmpVelocity.x;
+      sats[i].velocity.y = tmpVelocity.y;
+   }
+   if (chunkStart) {
+      traceSpan("physics chunk", "openmp", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "satellites", chunkSatellites);
+   }
+   }
+}
+
+// Rendering loop with --incremental. Along a row dy stays the same and dx
+// grows by one per pixel, so the squared distance to every satellite is
+// advanced with d2(w+1) = d2(w) + 2*dx(w) + 1, which is two additions in
+// place of two subtractions, two multiplies and an addition. The float
+// error grows with every step, so every incrementalReseed pixels the
+// distances are computed from scratch again.
+static void openmpIncrementalRun(const satellite *sats, int count, int mouseX, int mouseY,
+                                 color_u8 *out, int stride){
+   const float blackHoleRadiusSquared = BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS;
+   const float satelliteRadiusSquared = SATELLITE_RADIUS  * SATELLITE_RADIUS;
+
+#ifdef _OPENMP
+   const int threads = omp_get_max_threads();
+#else
+   const int threads = 1;
+#endif
+   // Whole cache lines per array, so the threads never share a line
+   const size_t lane = ((size_t)(count > 0 ? count : 1) + 15) & ~(size_t)15;
+   reserveIncremental(3 * lane * threads);
+
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkRows = 0;
+#ifdef _OPENMP
+   float *block = incrementalScratch + 3 * lane * omp_get_thread_num();
+#else
+   float *block = incrementalScratch;
+#endif
+   // Squared distances of the current and the next pixel to every
+   // satellite, and 2*dx + 1 of the current pixel
+   float *distances = block;
+   float *next = block + lane;
+   float *steps = block + 2 * lane;
+   int h;
+   #pragma omp for schedule(static) nowait
+   for (h=0; h<windowHeight; ++h){
+      chunkRows++;
+      int w;
+      for (w=0; w<windowWidth; ++w){
+      floatvector pixel = {.x = w, .y = h};
+      int i = h * stride + w; // compute linear index
+      int j;
+
+      if (w % incrementalReseed == 0) {
+         #pragma omp simd
+         for(j = 0; j < count; ++j){
+            float dx = pixel.x - sats[j].position.x;
+            float dy = pixel.y - sats[j].position.y;
+            distances[j] = dx * dx + dy * dy;
+            steps[j] = 2.0f * dx + 1.0f;
+         }
+      }
+
+      floatvector positionToBlackHole = {.x = pixel.x -
+         mouseX, .y = pixel.y - mouseY};
+      float distToBlackHoleSquared =
+         positionToBlackHole.x * positionToBlackHole.x +
+         positionToBlackHole.y * positionToBlackHole.y;
+      if (distToBlackHoleSquared < blackHoleRadiusSquared) {
+         // Black hole, only the distances move on
+         #pragma omp simd
+         for(j = 0; j < count; ++j){
+            next[j] = distances[j] + steps[j];
+            steps[j] += 2.0f;
+         }
+         out[i].red = 0;
+         out[i].green = 0;
+         out[i].blue = 0;
+      } else {
+         color_f32 renderColor = {.red = 0.f, .green = 0.f, .blue = 0.f};
+         float shortestDistanceSquared = INFINITY;
+         float weights = 0.f;
+         float rr = 0.f, rg = 0.f, rb = 0.f;
+         int hitsSatellite = 0;
+
+         // The fused loop of openmpGraphicsRun on the stored distances
+         #pragma omp simd reduction(+:weights,rr,rg,rb) reduction(min:shortestDistanceSquared) \
+                          reduction(|:hitsSatellite)
+         for(j = 0; j < count; ++j){
+            float distanceSquared = distances[j];
+            next[j] = distanceSquared + steps[j];
+            steps[j] += 2.0f;
+            hitsSatellite |= distanceSquared < satelliteRadiusSquared;
+            shortestDistanceSquared = distanceSquared < shortestDistanceSquared ?
+               distanceSquared : shortestDistanceSquared;
+
+            float weight = 1.0f / (distanceSquared*distanceSquared);
+            weights += weight;
+            rr += sats[j].identifier.red   * weight;
+            rg += sats[j].identifier.green * weight;
+            rb += sats[j].identifier.blue  * weight;
+         }
+
+         if (hitsSatellite) {
+            renderColor.red = 1.0f;
+            renderColor.green = 1.0f;
+            renderColor.blue = 1.0f;
+         } else {
+            for (j = 0; j + 1 < count && distances[j] != shortestDistanceSquared; ++j) {
+            }
+            renderColor = sats[j].identifier;
+            renderColor.red += rr * 3.0f / weights;
+            renderColor.green += rg * 3.0f / weights;
+            renderColor.blue += rb * 3.0f / weights;
+         }
+         out[i].red = (uint8_t) (renderColor.red * 255.0f);
+         out[i].green = (uint8_t) (renderColor.green * 255.0f);
+         out[i].blue = (uint8_t) (renderColor.blue * 255.0f);
+      }
+      float *swap = distances;
+      distances = next;
+      next = swap;
+      }
+   }
+   if (chunkStart) {
+      traceSpan("graphics chunk", "openmp", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "rows", chunkRows);
+   }
+   }
+}
+
+// Rendering loop (This is called once a frame after physics engine)
+// Decides the color for each pixel.
+static void openmpGraphicsRun(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out,
+                              int stride){
+
+   if (incrementalReseed > 0) {
+      openmpIncrementalRun(sats, count, mouseX, mouseY, out, stride);
+      return;
+   }
+
+   int tmpMousePosX = mouseX;
+   int tmpMousePosY = mouseY;
+
+   const float blackHoleRadiusSquared = BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS;
+   const float satelliteRadiusSquared = SATELLITE_RADIUS  * SATELLITE_RADIUS;
+
+   // Graphics pixel loop
+   // Every thread records its rows to the trace, as in the physics loop
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkRows = 0;
+   int h;
+   #pragma omp for schedule(static) nowait
+   for (h=0; h<windowHeight; ++h){
+      chunkRows++;
+      int w;
+      for (w=0; w<windowWidth; ++w){
+      // Row wise ordering
+      floatvector pixel = {.x = w, .y = h};
+      int i = h * stride + w; // compute linear index
+
+      // Draw the black hole
+      floatvector positionToBlackHole = {.x = pixel.x -
+         tmpMousePosX, .y = pixel.y - tmpMousePosY};
+      float distToBlackHoleSquared =
+         positionToBlackHole.x * positionToBlackHole.x +
+         positionToBlackHole.y * positionToBlackHole.y;
+      if (distToBlackHoleSquared < blackHoleRadiusSquared) {
+         out[i].red = 0;
+         out[i].green = 0;
+         out[i].blue = 0;
+         continue; // Black hole drawing done
+      }
+
+      // This color is used for coloring the pixel
+      color_f32 renderColor = {.red = 0.f, .green = 0.f, .blue = 0.f};
+
+      // Find closest satellite
+      uint64_t nearest = UINT64_MAX;
+
+      float weights = 0.f;
+      float rr = 0.f, rg = 0.f, rb = 0.f;
+      int hitsSatellite = 0;
+
+      // One graphics satellite loop: every distance and weight is computed
+      // once and goes into the total weight and the weighted color sums at
+      // the same time. A hit only sets a flag and the closest satellite is
+      // a minimum of nearestKey, so the loop has no branch and vectorises.
+      int j;
+      #pragma omp simd reduction(+:weights,rr,rg,rb) reduction(min:nearest) \
+                       reduction(|:hitsSatellite)
+      for(j = 0; j < count; ++j){
+         floatvector difference = {.x = pixel.x - sats[j].position.x,
+                                   .y = pixel.y - sats[j].position.y};
+         float distanceSquared = difference.x * difference.x +
+                                 difference.y * difference.y;
+         hitsSatellite |= distanceSquared < satelliteRadiusSquared;
+         uint64_t key = nearestKey(distanceSquared, j);
+         nearest = key < nearest ? key : nearest;
+
+         float weight = 1.0f / (distanceSquared*distanceSquared);
+         weights += weight;
+         rr += sats[j].identifier.red   * weight;
+         rg += sats[j].identifier.green * weight;
+         rb += sats[j].identifier.blue  * weight;
+      }
+
+      if (hitsSatellite) {
+         // Inside a satellite, the sums are not used
+         renderColor.red = 1.0f;
+         renderColor.green = 1.0f;
+         renderColor.blue = 1.0f;
+      } else {
+         // The low half of the key is the first satellite at the shortest
+         // distance, like the strict comparison of the sequential loop
+         renderColor = sats[count > 0 ? (int)(uint32_t)nearest : 0].identifier;
+         renderColor.red += rr * 3.0f / weights;
+         renderColor.green += rg * 3.0f / weights;
+         renderColor.blue += rb * 3.0f / weights;
+      }
+      out[i].red = (uint8_t) (renderColor.red * 255.0f);
+      out[i].green = (uint8_t) (renderColor.green * 255.0f);
+      out[i].blue = (uint8_t) (renderColor.blue * 255.0f);
+      }
+   }
+   if (chunkStart) {
+      traceSpan("graphics chunk", "openmp", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "rows", chunkRows);
+   }
+   }
+}
+
+static void openmpInit(void){
+}
+
+static void openmpDestroy(void){
+}
+
+static void openmpGraphicsDestroy(void){
+   alignedFree(incrementalScratch);
+   incrementalScratch = NULL;
+   incrementalCapacity = 0;
+}
+
+const PhysicsEngine openmpPhysics = {
+   .name = "openmp",
+   .init = openmpInit,
+   .destroy = openmpDestroy,
+   .run = openmpPhysicsRun
+};
+
+const GraphicsEngine openmpGraphics = {
+   .name = "openmp",
+   .init = openmpInit,
+   .destroy = openmpGraphicsDestroy,
+   .run = openmpGraphicsRun
+};
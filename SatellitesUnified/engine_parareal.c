@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Parallel in time physics (Parareal) ¤¤                       //
+//                                                                    //
+//    The substeps of a frame are split into time slices. A cheap     //
+//    coarse integrator (Yoshida, a few steps per slice) predicts the //
+//    state at the start of every slice, then all slices of all       //
+//    satellites run the fine Euler substeps in parallel and the      //
+//    predictions are corrected:                                      //
+//       U[n+1] = G(U[n]) + F(U_old[n]) - G(U_old[n])                 //
+//    Iteration k makes the first k+1 slices exact, so the result     //
+//    equals the reference after at most --slices iterations. It      //
+//    normally converges after one or two, so the fine work of a      //
+//    frame keeps satellites x slices threads busy.                   //
+////////////////////////////////////////////////////////////////////////
+
+#include "integrator.h"
+#include "satellites.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <math.h>
+#include <stdio.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Allowed distance from the reference after one frame, in pixels
+#define PARAREAL_TOLERANCE 0.001
+
+// Time slices per satellite (--slices), 0 uses enough slices to give
+// every thread work
+int pararealSlices = 0;
+// Iterations stop when no slice moves more than this (--parareal-tolerance)
+double pararealConvergence = 1e-7;
+// Coarse Yoshida steps per slice (--parareal-coarse)
+int pararealCoarseSteps = 1;
+
+typedef struct {
+   doublevector position;
+   doublevector velocity;
+} State;
+
+// Per satellite (slices+1) states of the current solution, of the coarse
+// solution of the previous iteration and of the fine solution
+static State *solution = NULL;
+static State *coarse = NULL;
+static State *fine = NULL;
+static unsigned char *converged = NULL;
+static int *iterations = NULL;
+static double *changes = NULL; // of the last iteration of every satellite
+static size_t stateCapacity = 0;
+static int satelliteCapacity = 0;
+
+// Statistics over all frames
+static unsigned int frames = 0;
+static int lastSlices = 0;
+static unsigned long long satelliteIterations = 0, satelliteFrames = 0;
+static int maxIterations = 0;
+static double lastChange = 0.0;
+
+static void reserveStates(int count, int slices){
+   size_t states = (size_t)count * (slices + 1);
+   if (states > stateCapacity) {
+      alignedFree(solution);
+      alignedFree(coarse);
+      alignedFree(fine);
+      solution = (State*)alignedAlloc(sizeof(State) * states);
+      coarse = (State*)alignedAlloc(sizeof(State) * states);
+      fine = (State*)alignedAlloc(sizeof(State) * states);
+      stateCapacity = states;
+   }
+   if (count > satelliteCapacity) {
+      free(converged);
+      free(iterations);
+      free(changes);
+      converged = (unsigned char*)malloc(count);
+      iterations = (int*)malloc(sizeof(int) * count);
+      changes = (double*)malloc(sizeof(double) * count);
+      satelliteCapacity = count;
+   }
+   if (!solution || !coarse || !fine || !converged || !iterations || !changes) {
+      printf("Out of memory for %d satellites in %d slices\n", count, slices);
+      exit(-1);
+   }
+}
+
+// First substep of slice n of slices
+static int sliceStart(int n, int slices){
+   return (int)((long long)n * physicsUpdatesPerFrame / slices);
+}
+
+// Fine propagator: the substeps of slice n. With the Euler integrator the
+// expressions are those of the reference, so an exact start state gives
+// the exact reference state at the end of the slice.
+static long long fineSlice(State *state, int n, int slices, int mouseX, int mouseY){
+   int steps = sliceStart(n + 1, slices) - sliceStart(n, slices);
+   if (integrator != INTEGRATOR_EULER) {
+      integrateSatelliteSpan(&state->position, &state->velocity, mouseX, mouseY,
+                             (double)DELTATIME * steps / physicsUpdatesPerFrame,
+                             steps, integrator);
+      return integratorForceEvaluations(integrator, steps);
+   }
+   doublevector p = state->position;
+   doublevector v = state->velocity;
+   for (int s = 0; s < steps; ++s) {
+      doublevector positionToBlackHole = {.x = p.x - mouseX, .y = p.y - mouseY};
+      double distToBlackHoleSquared =
+         positionToBlackHole.x * positionToBlackHole.x +
+         positionToBlackHole.y * positionToBlackHole.y;
+      double distToBlackHole = sqrt(distToBlackHoleSquared);
+      doublevector normalizedDirection = {
+         .x = positionToBlackHole.x / distToBlackHole,
+         .y = positionToBlackHole.y / distToBlackHole};
+      double accumulation = GRAVITY / distToBlackHoleSquared;
+      v.x -= accumulation * normalizedDirection.x * DELTATIME / physicsUpdatesPerFrame;
+      v.y -= accumulation * normalizedDirection.y * DELTATIME / physicsUpdatesPerFrame;
+      p.x += v.x * DELTATIME / physicsUpdatesPerFrame;
+      p.y += v.y * DELTATIME / physicsUpdatesPerFrame;
+   }
+   state->position = p;
+   state->velocity = v;
+   return steps;
+}
+
+// Coarse propagator over the same time as fineSlice()
+static long long coarseSlice(State *state, int n, int slices, int mouseX, int mouseY){
+   int steps = sliceStart(n + 1, slices) - sliceStart(n, slices);
+   integrateSatelliteSpan(&state->position, &state->velocity, mouseX, mouseY,
+                          (double)DELTATIME * steps / physicsUpdatesPerFrame,
+                          pararealCoarseSteps, INTEGRATOR_YOSHIDA4);
+   return integratorForceEvaluations(INTEGRATOR_YOSHIDA4, pararealCoarseSteps);
+}
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+static void pararealPhysicsRun(satellite *sats, int count, int mouseX, int mouseY){
+   int slices = pararealSlices;
+   if (slices <= 0) {
+#ifdef _OPENMP
+      int threads = omp_get_max_threads();
+#else
+      int threads = 1;
+#endif
+      slices = count > 0 ? (threads + count - 1) / count : 1;
+   }
+   if (slices > physicsUpdatesPerFrame) {
+      slices = physicsUpdatesPerFrame;
+   }
+   const int stride = slices + 1;
+   reserveStates(count, slices);
+   long long evaluations = 0;
+
+   // Initial coarse prediction of every slice
+   int i;
+   #pragma omp parallel for schedule(static) reduction(+:evaluations)
+   for (i = 0; i < count; ++i) {
+      State *u = &solution[(size_t)i * stride];
+      State *g = &coarse[(size_t)i * stride];
+      u[0].position.x = sats[i].position.x;
+      u[0].position.y = sats[i].position.y;
+      u[0].velocity.x = sats[i].velocity.x;
+      u[0].velocity.y = sats[i].velocity.y;
+      for (int n = 0; n < slices; ++n) {
+         g[n + 1] = u[n];
+         evaluations += coarseSlice(&g[n + 1], n, slices, mouseX, mouseY);
+         u[n + 1] = g[n + 1];
+      }
+      converged[i] = 0;
+      iterations[i] = 0;
+      changes[i] = 0.0;
+   }
+
+   for (int k = 0; k < slices; ++k) {
+      // Fine solves of the slices that are not exact yet, all in parallel
+      uint64_t fineStart = timingNow();
+      int tasks = count * slices;
+      int t;
+      const int traceRows = traceOpenmpRows();
+      #pragma omp parallel
+      {
+      uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+      int chunkSlices = 0;
+      #pragma omp for schedule(dynamic, 1) reduction(+:evaluations) nowait
+      for (t = 0; t < tasks; ++t) {
+         int s = t / slices;
+         int n = t % slices;
+         if (converged[s] || n < k) {
+            continue;
+         }
+         chunkSlices++;
+         State *f = &fine[(size_t)s * stride];
+         f[n + 1] = solution[(size_t)s * stride + n];
+         evaluations += fineSlice(&f[n + 1], n, slices, mouseX, mouseY);
+      }
+      if (chunkStart) {
+         traceSpan("fine slices", "parareal", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                   "slices", chunkSlices);
+      }
+      }
+      traceSpan("parareal iteration", "parareal", TRACE_TID_MAIN, fineStart, timingNow(),
+                "iteration", k);
+
+      // Serial correction sweep of every satellite
+      int active = 0;
+      #pragma omp parallel for schedule(static) reduction(+:evaluations, active)
+      for (i = 0; i < count; ++i) {
+         if (converged[i]) {
+            continue;
+         }
+         State *u = &solution[(size_t)i * stride];
+         State *g = &coarse[(size_t)i * stride];
+         State *f = &fine[(size_t)i * stride];
+         double change = 0.0;
+         for (int n = k; n < slices; ++n) {
+            State next;
+            if (n == k) {
+               // The start of slice k is exact, so is its fine solution
+               next = f[n + 1];
+            } else {
+               State predicted = u[n];
+               evaluations += coarseSlice(&predicted, n, slices, mouseX, mouseY);
+               next.position.x = predicted.position.x + (f[n + 1].position.x - g[n + 1].position.x);
+               next.position.y = predicted.position.y + (f[n + 1].position.y - g[n + 1].position.y);
+               next.velocity.x = predicted.velocity.x + (f[n + 1].velocity.x - g[n + 1].velocity.x);
+               next.velocity.y = predicted.velocity.y + (f[n + 1].velocity.y - g[n + 1].velocity.y);
+               g[n + 1] = predicted;
+            }
+            double dx = next.position.x - u[n + 1].position.x;
+            double dy = next.position.y - u[n + 1].position.y;
+            double distance = sqrt(dx * dx + dy * dy);
+            if (!(distance <= change)) {
+               change = isnan(distance) ? INFINITY : distance;
+            }
+            u[n + 1] = next;
+         }
+         iterations[i] = k + 1;
+         changes[i] = change;
+         if (change <= pararealConvergence || k == slices - 1) {
+            converged[i] = 1;
+         } else {
+            active++;
+         }
+      }
+      if (!active) {
+         break;
+      }
+   }
+
+   // copy back the float storage.
+   int frameMaxIterations = 0;
+   double worstChange = 0.0;
+   for (i = 0; i < count; ++i) {
+      const State *end = &solution[(size_t)i * stride + slices];
+      sats[i].position.x = end->position.x;
+      sats[i].position.y = end->position.y;
+      sats[i].velocity.x = end->velocity.x;
+      sats[i].velocity.y = end->velocity.y;
+      satelliteIterations += iterations[i];
+      if (iterations[i] > frameMaxIterations) {
+         frameMaxIterations = iterations[i];
+      }
+      if (changes[i] > worstChange) {
+         worstChange = changes[i];
+      }
+   }
+   satelliteFrames += count;
+   if (frameMaxIterations > maxIterations) {
+      maxIterations = frameMaxIterations;
+   }
+   frames++;
+   lastSlices = slices;
+   lastChange = worstChange;
+   frameForceEvaluations = evaluations;
+}
+
+void pararealPrint(void){
+   if (!frames) {
+      return;
+   }
+   printf("Parareal: %d slices, iterations per satellite and frame mean %.2f max %d, "
+          "last change %.3g px\n", lastSlices,
+          satelliteFrames ? (double)satelliteIterations / satelliteFrames : 0.0,
+          maxIterations, lastChange);
+}
+
+void pararealPrintJson(FILE *f){
+   fprintf(f, "{\"slices\":%d,\"frames\":%u,\"iterations_mean\":%.4f,\"iterations_max\":%d,"
+              "\"convergence_px\":%g,\"last_change_px\":%g}",
+           lastSlices, frames,
+           satelliteFrames ? (double)satelliteIterations / satelliteFrames : 0.0,
+           maxIterations, pararealConvergence, lastChange);
+}
+
+static void pararealInit(void){
+}
+
+static void pararealDestroy(void){
+   alignedFree(solution);
+   alignedFree(coarse);
+   alignedFree(fine);
+   free(converged);
+   free(iterations);
+   free(changes);
+   solution = coarse = fine = NULL;
+   converged = NULL;
+   iterations = NULL;
+   changes = NULL;
+   stateCapacity = 0;
+   satelliteCapacity = 0;
+}
+
+const PhysicsEngine pararealPhysics = {
+   .name = "parareal",
+   .init = pararealInit,
+   .destroy = pararealDestroy,
+   .run = pararealPhysicsRun,
+   .tolerance = PARAREAL_TOLERANCE
+};
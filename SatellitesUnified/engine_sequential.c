@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////
+//    ¤¤ Physics and Graphic both on CPU, single thread ¤¤          //
+//                                                                  //
+//    Same code as SatellitesOriginal, used as the baseline engine  //
+//////////////////////////////////////////////////////////////////////
+
+#include "integrator.h"
+#include "satellites.h"
+
+#include <math.h> // INFINITY
+#include <stdio.h>
+
+// double precision state of the satellites, kept between frames so that
+// it is only reallocated when the satellite count grows
+static doublevector *tmpPosition = NULL;
+static doublevector *tmpVelocity = NULL;
+static int tmpCapacity = 0;
+
+static void reserveScratch(int count){
+   if (count <= tmpCapacity) {
+      return;
+   }
+   alignedFree(tmpPosition);
+   alignedFree(tmpVelocity);
+   tmpPosition = (doublevector*)alignedAlloc(sizeof(doublevector) * count);
+   tmpVelocity = (doublevector*)alignedAlloc(sizeof(doublevector) * count);
+   if (!tmpPosition || !tmpVelocity) {
+      printf("Out of memory for %d satellites\n", count);
+      exit(-1);
+   }
+   tmpCapacity = count;
+}
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+// Moves the satellites based on gravity
+// This is done multiple times in a frame because the Euler integration
+// is not accurate enough to be done only once (see --integrator)
+static void sequentialPhysicsRun(satellite *sats, int count, int mouseX, int mouseY){
+
+   int tmpMousePosX = mouseX;
+   int tmpMousePosY = mouseY;
+
+   // double precision required for accumulation inside this routine,
+   // but float storage is ok outside these loops.
+   reserveScratch(count);
+
+   frameForceEvaluations = count * integratorForceEvaluations(integrator, physicsUpdatesPerFrame);
+
+   int idx;
+   for (idx = 0; idx < count; ++idx) {
+       tmpPosition[idx].x = sats[idx].position.x;
+       tmpPosition[idx].y = sats[idx].position.y;
+       tmpVelocity[idx].x = sats[idx].velocity.x;
+       tmpVelocity[idx].y = sats[idx].velocity.y;
+   }
+
+   // Adaptive steps and higher order integrators walk the substeps of one
+   // satellite at a time
+   if (adaptiveEta > 0.0) {
+      long long evaluations = 0;
+      for (idx = 0; idx < count; ++idx) {
+         evaluations += integrateSatelliteAdaptive(&tmpPosition[idx], &tmpVelocity[idx],
+                                                   tmpMousePosX, tmpMousePosY, adaptiveEta,
+                                                   physicsUpdatesPerFrame, integrator);
+      }
+      frameForceEvaluations = evaluations;
+   } else if (integrator != INTEGRATOR_EULER) {
+      for (idx = 0; idx < count; ++idx) {
+         integrateSatellite(&tmpPosition[idx], &tmpVelocity[idx], tmpMousePosX,
+                            tmpMousePosY, physicsUpdatesPerFrame, integrator);
+      }
+   } else {
+      int physicsUpdateIndex;
+      // Physics iteration loop
+      for(physicsUpdateIndex = 0;
+          physicsUpdateIndex < physicsUpdatesPerFrame;
+         ++physicsUpdateIndex){
+         int i;
+          // Physics satellite loop
+         for(i = 0; i < count; ++i){
+
+            // Distance to the blackhole (bit ugly code because C-struct cannot have member functions)
+            doublevector positionToBlackHole = {.x = tmpPosition[i].x -
+               tmpMousePosX, .y = tmpPosition[i].y - tmpMousePosY};
+            double distToBlackHoleSquared =
+               positionToBlackHole.x * positionToBlackHole.x +
+               positionToBlackHole.y * positionToBlackHole.y;
+            double distToBlackHole = sqrt(distToBlackHoleSquared);
+
+            // Gravity force
+            doublevector normalizedDirection = {
+               .x = positionToBlackHole.x / distToBlackHole,
+               .y = positionToBlackHole.y / distToBlackHole};
+            double accumulation = GRAVITY / distToBlackHoleSquared;
+
+            // Delta time is used to make velocity same despite different FPS
+            // Update velocity based on force
+            tmpVelocity[i].x -= accumulation * normalizedDirection.x *
+               DELTATIME / physicsUpdatesPerFrame;
+            tmpVelocity[i].y -= accumulation * normalizedDirection.y *
+               DELTATIME / physicsUpdatesPerFrame;
+
+            // Update position based on velocity
+            tmpPosition[i].x +=
+               tmpVelocity[i].x * DELTATIME / physicsUpdatesPerFrame;
+            tmpPosition[i].y +=
+               tmpVelocity[i].y * DELTATIME / physicsUpdatesPerFrame;
+         }
+      }
+   }
+
+   // double precision required for accumulation inside this routine,
+   // but float storage is ok outside these loops.
+   // copy back the float storage.
+   int idx2;
+   for (idx2 = 0; idx2 < count; ++idx2) {
+       sats[idx2].position.x = tmpPosition[idx2].x;
+       sats[idx2].position.y = tmpPosition[idx2].y;
+       sats[idx2].velocity.x = tmpVelocity[idx2].x;
+       sats[idx2].velocity.y = tmpVelocity[idx2].y;
+   }
+}
+
+// Rendering loop (This is called once a frame after physics engine)
+// Decides the color for each pixel.
+static void sequentialGraphicsRun(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out,
+                                  int stride){
+
+   int tmpMousePosX = mouseX;
+   int tmpMousePosY = mouseY;
+
+    // Graphics pixel loop
+    int i;
+    for(i = 0 ;i < SIZE; ++i) {
+
+      // Row wise ordering
+      floatvector pixel = {.x = i % windowWidth, .y = i / windowWidth};
+      int o = i / windowWidth * stride + i % windowWidth; // index in out
+
+      // Draw the black hole
+      floatvector positionToBlackHole = {.x = pixel.x -
+         tmpMousePosX, .y = pixel.y - tmpMousePosY};
+      float distToBlackHoleSquared =
+         positionToBlackHole.x * positionToBlackHole.x +
+         positionToBlackHole.y * positionToBlackHole.y;
+      float distToBlackHole = sqrt(distToBlackHoleSquared);
+      if (distToBlackHole < BLACK_HOLE_RADIUS) {
+         out[o].red = 0;
+         out[o].green = 0;
+         out[o].blue = 0;
+         continue; // Black hole drawing done
+      }
+
+      // This color is used for coloring the pixel
+      color_f32 renderColor = {.red = 0.f, .green = 0.f, .blue = 0.f};
+
+      // Find closest satellite
+      float shortestDistance = INFINITY;
+
+      float weights = 0.f;
+      int hitsSatellite = 0;
+
+      // First Graphics satellite loop: Find the closest satellite.
+      int j;
+      for(j = 0; j < count; ++j){
+         floatvector difference = {.x = pixel.x - sats[j].position.x,
+                                   .y = pixel.y - sats[j].position.y};
+         float distance = sqrt(difference.x * difference.x +
+                               difference.y * difference.y);
+
+         if(distance < SATELLITE_RADIUS) {
+            renderColor.red = 1.0f;
+            renderColor.green = 1.0f;
+            renderColor.blue = 1.0f;
+            hitsSatellite = 1;
+            break;
+         } else {
+            float weight = 1.0f / (distance*distance*distance*distance);
+            weights += weight;
+            if(distance < shortestDistance){
+               shortestDistance = distance;
+               renderColor = sats[j].identifier;
+            }
+         }
+      }
+
+      // Second graphics loop: Calculate the color based on distance to every satellite.
+      if (!hitsSatellite) {
+         int k;
+         for(k = 0; k < count; ++k){
+            floatvector difference = {.x = pixel.x - sats[k].position.x,
+                                      .y = pixel.y - sats[k].position.y};
+            float dist2 = (difference.x * difference.x +
+                           difference.y * difference.y);
+            float weight = 1.0f/(dist2* dist2);
+
+            renderColor.red += (sats[k].identifier.red *
+                                weight /weights) * 3.0f;
+
+            renderColor.green += (sats[k].identifier.green *
+                                  weight / weights) * 3.0f;
+
+            renderColor.blue += (sats[k].identifier.blue *
+                                 weight / weights) * 3.0f;
+         }
+      }
+      out[o].red = (uint8_t) (renderColor.red * 255.0f);
+      out[o].green = (uint8_t) (renderColor.green * 255.0f);
+      out[o].blue = (uint8_t) (renderColor.blue * 255.0f);
+    }
+}
+
+static void sequentialInit(void){
+}
+
+static void sequentialDestroy(void){
+}
+
+static void sequentialPhysicsDestroy(void){
+   alignedFree(tmpPosition);
+   alignedFree(tmpVelocity);
+   tmpPosition = NULL;
+   tmpVelocity = NULL;
+   tmpCapacity = 0;
+}
+
+const PhysicsEngine sequentialPhysics = {
+   .name = "sequential",
+   .init = sequentialInit,
+   .destroy = sequentialPhysicsDestroy,
+   .run = sequentialPhysicsRun
+};
+
+const GraphicsEngine sequentialGraphics = {
+   .name = "sequential",
+   .init = sequentialInit,
+   .destroy = sequentialDestroy,
+   .run = sequentialGraphicsRun
+};
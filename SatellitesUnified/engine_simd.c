@@ -0,0 +1,626 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Physics and graphics on CPU with vector instructions ¤¤      //
+//                                                                    //
+//    The double state is kept as a structure of arrays, so one       //
+//    AVX-512 (AVX2) instruction advances 8 (4) satellites. The       //
+//    blocks of satellites are spread over the OpenMP threads. Every  //
+//    lane does exactly the operations of the reference code in the   //
+//    same order, so the result is bit by bit the same. This file     //
+//    must be compiled without floating point contraction (FMA).     //
+//                                                                    //
+//    The graphics shade 16 (8) neighbouring pixels of a row per      //
+//    instruction, the rows are spread over the OpenMP threads.       //
+////////////////////////////////////////////////////////////////////////
+
+#include "integrator.h"
+#include "satellites.h"
+#include "simd.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Widest block, the arrays are padded to a multiple of it
+#define SIMD_MAX_LANES 8
+
+// Structure of arrays double state, grown like the scratch buffers of the
+// sequential engine
+static double *positionX = NULL;
+static double *positionY = NULL;
+static double *velocityX = NULL;
+static double *velocityY = NULL;
+static int soaCapacity = 0;
+
+static void reserveSoa(int count){
+   int padded = (count + SIMD_MAX_LANES - 1) / SIMD_MAX_LANES * SIMD_MAX_LANES;
+   if (padded <= soaCapacity) {
+      return;
+   }
+   alignedFree(positionX);
+   alignedFree(positionY);
+   alignedFree(velocityX);
+   alignedFree(velocityY);
+   positionX = (double*)alignedAlloc(sizeof(double) * padded);
+   positionY = (double*)alignedAlloc(sizeof(double) * padded);
+   velocityX = (double*)alignedAlloc(sizeof(double) * padded);
+   velocityY = (double*)alignedAlloc(sizeof(double) * padded);
+   if (!positionX || !positionY || !velocityX || !velocityY) {
+      printf("Out of memory for %d satellites\n", count);
+      exit(-1);
+   }
+   soaCapacity = padded;
+}
+
+// One satellite at index i, same expressions as sequentialPhysicsEngine
+static void eulerScalar(int i, double mouseX, double mouseY, int substeps){
+   double x = positionX[i], y = positionY[i];
+   double vx = velocityX[i], vy = velocityY[i];
+   for (int s = 0; s < substeps; ++s) {
+      double dx = x - mouseX;
+      double dy = y - mouseY;
+      double distToBlackHoleSquared = dx * dx + dy * dy;
+      double distToBlackHole = sqrt(distToBlackHoleSquared);
+      double normalizedDirectionX = dx / distToBlackHole;
+      double normalizedDirectionY = dy / distToBlackHole;
+      double accumulation = GRAVITY / distToBlackHoleSquared;
+      vx -= accumulation * normalizedDirectionX * DELTATIME / substeps;
+      vy -= accumulation * normalizedDirectionY * DELTATIME / substeps;
+      x += vx * DELTATIME / substeps;
+      y += vy * DELTATIME / substeps;
+   }
+   positionX[i] = x; positionY[i] = y;
+   velocityX[i] = vx; velocityY[i] = vy;
+}
+
+#ifdef HAVE_SIMD_X86
+// 4 satellites starting at index i
+SIMD_TARGET_AVX2
+static void eulerAvx2(int i, double mouseX, double mouseY, int substeps){
+   __m256d x = _mm256_load_pd(positionX + i);
+   __m256d y = _mm256_load_pd(positionY + i);
+   __m256d vx = _mm256_load_pd(velocityX + i);
+   __m256d vy = _mm256_load_pd(velocityY + i);
+   const __m256d mx = _mm256_set1_pd(mouseX);
+   const __m256d my = _mm256_set1_pd(mouseY);
+   const __m256d gravity = _mm256_set1_pd(GRAVITY);
+   const __m256d deltaTime = _mm256_set1_pd(DELTATIME);
+   const __m256d steps = _mm256_set1_pd(substeps);
+   for (int s = 0; s < substeps; ++s) {
+      __m256d dx = _mm256_sub_pd(x, mx);
+      __m256d dy = _mm256_sub_pd(y, my);
+      __m256d distToBlackHoleSquared = _mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                                     _mm256_mul_pd(dy, dy));
+      __m256d distToBlackHole = _mm256_sqrt_pd(distToBlackHoleSquared);
+      __m256d normalizedDirectionX = _mm256_div_pd(dx, distToBlackHole);
+      __m256d normalizedDirectionY = _mm256_div_pd(dy, distToBlackHole);
+      __m256d accumulation = _mm256_div_pd(gravity, distToBlackHoleSquared);
+      // ((accumulation * direction) * DELTATIME) / substeps, like the reference
+      vx = _mm256_sub_pd(vx, _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(
+              accumulation, normalizedDirectionX), deltaTime), steps));
+      vy = _mm256_sub_pd(vy, _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(
+              accumulation, normalizedDirectionY), deltaTime), steps));
+      x = _mm256_add_pd(x, _mm256_div_pd(_mm256_mul_pd(vx, deltaTime), steps));
+      y = _mm256_add_pd(y, _mm256_div_pd(_mm256_mul_pd(vy, deltaTime), steps));
+   }
+   _mm256_store_pd(positionX + i, x);
+   _mm256_store_pd(positionY + i, y);
+   _mm256_store_pd(velocityX + i, vx);
+   _mm256_store_pd(velocityY + i, vy);
+}
+
+// 8 satellites starting at index i
+SIMD_TARGET_AVX512
+static void eulerAvx512(int i, double mouseX, double mouseY, int substeps){
+   __m512d x = _mm512_load_pd(positionX + i);
+   __m512d y = _mm512_load_pd(positionY + i);
+   __m512d vx = _mm512_load_pd(velocityX + i);
+   __m512d vy = _mm512_load_pd(velocityY + i);
+   const __m512d mx = _mm512_set1_pd(mouseX);
+   const __m512d my = _mm512_set1_pd(mouseY);
+   const __m512d gravity = _mm512_set1_pd(GRAVITY);
+   const __m512d deltaTime = _mm512_set1_pd(DELTATIME);
+   const __m512d steps = _mm512_set1_pd(substeps);
+   for (int s = 0; s < substeps; ++s) {
+      __m512d dx = _mm512_sub_pd(x, mx);
+      __m512d dy = _mm512_sub_pd(y, my);
+      __m512d distToBlackHoleSquared = _mm512_add_pd(_mm512_mul_pd(dx, dx),
+                                                     _mm512_mul_pd(dy, dy));
+      __m512d distToBlackHole = _mm512_sqrt_pd(distToBlackHoleSquared);
+      __m512d normalizedDirectionX = _mm512_div_pd(dx, distToBlackHole);
+      __m512d normalizedDirectionY = _mm512_div_pd(dy, distToBlackHole);
+      __m512d accumulation = _mm512_div_pd(gravity, distToBlackHoleSquared);
+      vx = _mm512_sub_pd(vx, _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(
+              accumulation, normalizedDirectionX), deltaTime), steps));
+      vy = _mm512_sub_pd(vy, _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(
+              accumulation, normalizedDirectionY), deltaTime), steps));
+      x = _mm512_add_pd(x, _mm512_div_pd(_mm512_mul_pd(vx, deltaTime), steps));
+      y = _mm512_add_pd(y, _mm512_div_pd(_mm512_mul_pd(vy, deltaTime), steps));
+   }
+   _mm512_store_pd(positionX + i, x);
+   _mm512_store_pd(positionY + i, y);
+   _mm512_store_pd(velocityX + i, vx);
+   _mm512_store_pd(velocityY + i, vy);
+}
+#endif
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+// Only the Euler integration with equal steps is vectorised, the other
+// integrators and --adaptive run one satellite per thread like openmp.
+static void simdPhysicsRun(satellite *sats, int count, int mouseX, int mouseY){
+   if (integrator != INTEGRATOR_EULER || adaptiveEta > 0.0) {
+      long long evaluations = 0;
+      int i;
+      #pragma omp parallel for schedule(dynamic, 1) reduction(+:evaluations)
+      for (i = 0; i < count; ++i) {
+         doublevector p = {.x = sats[i].position.x, .y = sats[i].position.y};
+         doublevector v = {.x = sats[i].velocity.x, .y = sats[i].velocity.y};
+         if (adaptiveEta > 0.0) {
+            evaluations += integrateSatelliteAdaptive(&p, &v, mouseX, mouseY, adaptiveEta,
+                                                      physicsUpdatesPerFrame, integrator);
+         } else {
+            integrateSatellite(&p, &v, mouseX, mouseY, physicsUpdatesPerFrame, integrator);
+            evaluations += integratorForceEvaluations(integrator, physicsUpdatesPerFrame);
+         }
+         sats[i].position.x = p.x;
+         sats[i].position.y = p.y;
+         sats[i].velocity.x = v.x;
+         sats[i].velocity.y = v.y;
+      }
+      frameForceEvaluations = evaluations;
+      return;
+   }
+   frameForceEvaluations = count * integratorForceEvaluations(integrator, physicsUpdatesPerFrame);
+   if (count <= 0) {
+      return;
+   }
+
+   // float -> double into the structure of arrays. The padding lanes copy
+   // the last satellite, so they never divide by zero; they are not stored.
+   reserveSoa(count);
+   for (int i = 0; i < soaCapacity; ++i) {
+      const satellite *s = &sats[i < count ? i : count - 1];
+      positionX[i] = s->position.x;
+      positionY[i] = s->position.y;
+      velocityX[i] = s->velocity.x;
+      velocityY[i] = s->velocity.y;
+   }
+
+   const int level = simdLevel();
+   const int lanes = level == SIMD_AVX512 ? 8 : level == SIMD_AVX2 ? 4 : 1;
+   const int blocks = (count + lanes - 1) / lanes;
+
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkSatellites = 0;
+   int b;
+   #pragma omp for schedule(static) nowait
+   for (b = 0; b < blocks; ++b) {
+      chunkSatellites += count - b * lanes < lanes ? count - b * lanes : lanes;
+#ifdef HAVE_SIMD_X86
+      if (level == SIMD_AVX512) {
+         eulerAvx512(b * lanes, mouseX, mouseY, physicsUpdatesPerFrame);
+      } else if (level == SIMD_AVX2) {
+         eulerAvx2(b * lanes, mouseX, mouseY, physicsUpdatesPerFrame);
+      } else
+#endif
+      {
+         eulerScalar(b * lanes, mouseX, mouseY, physicsUpdatesPerFrame);
+      }
+   }
+   if (chunkStart) {
+      traceSpan("physics chunk", "simd", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "satellites", chunkSatellites);
+   }
+   }
+
+   // copy back the float storage.
+   for (int i = 0; i < count; ++i) {
+      sats[i].position.x = positionX[i];
+      sats[i].position.y = positionY[i];
+      sats[i].velocity.x = velocityX[i];
+      sats[i].velocity.y = velocityY[i];
+   }
+}
+
+static void simdPhysicsInit(void){
+   int level = simdLevel();
+   printf("SIMD physics: %s, %d satellites per instruction\n", simdName(level),
+          level == SIMD_AVX512 ? 8 : level == SIMD_AVX2 ? 4 : 1);
+}
+
+static void simdPhysicsDestroy(void){
+   alignedFree(positionX);
+   alignedFree(positionY);
+   alignedFree(velocityX);
+   alignedFree(velocityY);
+   positionX = positionY = velocityX = velocityY = NULL;
+   soaCapacity = 0;
+}
+
+const PhysicsEngine simdPhysics = {
+   .name = "simd",
+   .init = simdPhysicsInit,
+   .destroy = simdPhysicsDestroy,
+   .run = simdPhysicsRun
+};
+
+////////////////////////////////////////////////
+// ¤¤ Graphics ¤¤                             //
+////////////////////////////////////////////////
+
+// The two satellite loops of the openmp engine are fused into one pass:
+// every satellite adds to the weight sum and to the weighted color sums,
+// a lane-wise compare keeps the nearest color and a mask collects the
+// hits. There is no early exit per pixel, a hit lane just turns white at
+// the end, so all lanes of a block follow the same path. The distances
+// are compared squared like in the openmp engine, which stays within
+// ALLOWED_ERROR of the reference.
+
+// One pixel, used for the scalar level and the ends of the rows
+static color_u8 shadeScalar(const satellite *sats, int count, int x, int y,
+                            int mouseX, int mouseY){
+   color_u8 result = {.red = 0, .green = 0, .blue = 0, .reserved = 0};
+   floatvector pixel = {.x = x, .y = y};
+   floatvector positionToBlackHole = {.x = pixel.x - mouseX, .y = pixel.y - mouseY};
+   if (positionToBlackHole.x * positionToBlackHole.x +
+       positionToBlackHole.y * positionToBlackHole.y < BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS) {
+      return result;
+   }
+   color_f32 nearest = {.red = 0.f, .green = 0.f, .blue = 0.f};
+   float shortestDistanceSquared = INFINITY;
+   float weights = 0.f, rr = 0.f, rg = 0.f, rb = 0.f;
+   for (int j = 0; j < count; ++j) {
+      float dx = pixel.x - sats[j].position.x;
+      float dy = pixel.y - sats[j].position.y;
+      float distanceSquared = dx * dx + dy * dy;
+      if (distanceSquared < SATELLITE_RADIUS * SATELLITE_RADIUS) {
+         result.red = result.green = result.blue = 255;
+         return result;
+      }
+      float weight = 1.0f / (distanceSquared * distanceSquared);
+      weights += weight;
+      rr += sats[j].identifier.red * weight;
+      rg += sats[j].identifier.green * weight;
+      rb += sats[j].identifier.blue * weight;
+      if (distanceSquared < shortestDistanceSquared) {
+         shortestDistanceSquared = distanceSquared;
+         nearest = sats[j].identifier;
+      }
+   }
+   result.red = (uint8_t)((nearest.red + rr * 3.0f / weights) * 255.0f);
+   result.green = (uint8_t)((nearest.green + rg * 3.0f / weights) * 255.0f);
+   result.blue = (uint8_t)((nearest.blue + rb * 3.0f / weights) * 255.0f);
+   return result;
+}
+
+#ifdef HAVE_SIMD_X86
+// 8 pixels of row y starting at column x. With testDiscs 0 the pixels are
+// known to be outside the black hole and every satellite, as in
+// shade_pixel of parallel.cl, and only the field is summed: no masks and
+// no early exit.
+SIMD_TARGET_AVX2
+static inline void shadeAvx2(const satellite *sats, int count, int x, int y,
+                             int mouseX, int mouseY, color_u8 *out, const int testDiscs){
+   const __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x),
+                                   _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+   const __m256 py = _mm256_set1_ps((float)y);
+   const __m256 zero = _mm256_setzero_ps();
+   const __m256 one = _mm256_set1_ps(1.0f);
+   const __m256 satelliteRadiusSquared = _mm256_set1_ps(SATELLITE_RADIUS * SATELLITE_RADIUS);
+
+   __m256 blackHole = zero;
+   if (testDiscs) {
+      __m256 bx = _mm256_sub_ps(px, _mm256_set1_ps((float)mouseX));
+      __m256 by = _mm256_sub_ps(py, _mm256_set1_ps((float)mouseY));
+      blackHole = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(bx, bx), _mm256_mul_ps(by, by)),
+                                _mm256_set1_ps(BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS),
+                                _CMP_LT_OQ);
+   }
+   __m256 hit = zero;
+   __m256 shortest = _mm256_set1_ps(INFINITY);
+   __m256 weights = zero, rr = zero, rg = zero, rb = zero;
+   __m256 nr = zero, ng = zero, nb = zero;
+   for (int j = 0; j < count; ++j) {
+      __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(sats[j].position.x));
+      __m256 dy = _mm256_sub_ps(py, _mm256_set1_ps(sats[j].position.y));
+      __m256 distanceSquared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+      if (testDiscs) {
+         hit = _mm256_or_ps(hit, _mm256_cmp_ps(distanceSquared, satelliteRadiusSquared, _CMP_LT_OQ));
+      }
+      __m256 weight = _mm256_div_ps(one, _mm256_mul_ps(distanceSquared, distanceSquared));
+      __m256 red = _mm256_set1_ps(sats[j].identifier.red);
+      __m256 green = _mm256_set1_ps(sats[j].identifier.green);
+      __m256 blue = _mm256_set1_ps(sats[j].identifier.blue);
+      weights = _mm256_add_ps(weights, weight);
+      rr = _mm256_add_ps(rr, _mm256_mul_ps(red, weight));
+      rg = _mm256_add_ps(rg, _mm256_mul_ps(green, weight));
+      rb = _mm256_add_ps(rb, _mm256_mul_ps(blue, weight));
+      __m256 closer = _mm256_cmp_ps(distanceSquared, shortest, _CMP_LT_OQ);
+      shortest = _mm256_blendv_ps(shortest, distanceSquared, closer);
+      nr = _mm256_blendv_ps(nr, red, closer);
+      ng = _mm256_blendv_ps(ng, green, closer);
+      nb = _mm256_blendv_ps(nb, blue, closer);
+      if (testDiscs && _mm256_movemask_ps(_mm256_or_ps(hit, blackHole)) == 0xff) {
+         break; // Every lane is decided
+      }
+   }
+   const __m256 three = _mm256_set1_ps(3.0f);
+   const __m256 scale = _mm256_set1_ps(255.0f);
+   __m256 red = _mm256_add_ps(nr, _mm256_div_ps(_mm256_mul_ps(rr, three), weights));
+   __m256 green = _mm256_add_ps(ng, _mm256_div_ps(_mm256_mul_ps(rg, three), weights));
+   __m256 blue = _mm256_add_ps(nb, _mm256_div_ps(_mm256_mul_ps(rb, three), weights));
+   if (testDiscs) {
+      red = _mm256_blendv_ps(_mm256_blendv_ps(red, one, hit), zero, blackHole);
+      green = _mm256_blendv_ps(_mm256_blendv_ps(green, one, hit), zero, blackHole);
+      blue = _mm256_blendv_ps(_mm256_blendv_ps(blue, one, hit), zero, blackHole);
+   }
+   // color_u8 is blue, green, red, reserved in memory
+   __m256i bgr = _mm256_or_si256(
+      _mm256_or_si256(_mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(red, scale)), 16),
+                      _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(green, scale)), 8)),
+      _mm256_cvttps_epi32(_mm256_mul_ps(blue, scale)));
+   _mm256_storeu_si256((__m256i*)out, bgr);
+}
+
+// 16 pixels of row y starting at column x, testDiscs as in shadeAvx2
+SIMD_TARGET_AVX512
+static inline void shadeAvx512(const satellite *sats, int count, int x, int y,
+                               int mouseX, int mouseY, color_u8 *out, const int testDiscs){
+   const __m512 px = _mm512_add_ps(_mm512_set1_ps((float)x),
+                                   _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7,
+                                                  8, 9, 10, 11, 12, 13, 14, 15));
+   const __m512 py = _mm512_set1_ps((float)y);
+   const __m512 zero = _mm512_setzero_ps();
+   const __m512 one = _mm512_set1_ps(1.0f);
+   const __m512 satelliteRadiusSquared = _mm512_set1_ps(SATELLITE_RADIUS * SATELLITE_RADIUS);
+
+   __mmask16 blackHole = 0;
+   if (testDiscs) {
+      __m512 bx = _mm512_sub_ps(px, _mm512_set1_ps((float)mouseX));
+      __m512 by = _mm512_sub_ps(py, _mm512_set1_ps((float)mouseY));
+      blackHole = _mm512_cmp_ps_mask(
+         _mm512_add_ps(_mm512_mul_ps(bx, bx), _mm512_mul_ps(by, by)),
+         _mm512_set1_ps(BLACK_HOLE_RADIUS * BLACK_HOLE_RADIUS), _CMP_LT_OQ);
+   }
+   __mmask16 hit = 0;
+   __m512 shortest = _mm512_set1_ps(INFINITY);
+   __m512 weights = zero, rr = zero, rg = zero, rb = zero;
+   __m512 nr = zero, ng = zero, nb = zero;
+   for (int j = 0; j < count; ++j) {
+      __m512 dx = _mm512_sub_ps(px, _mm512_set1_ps(sats[j].position.x));
+      __m512 dy = _mm512_sub_ps(py, _mm512_set1_ps(sats[j].position.y));
+      __m512 distanceSquared = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+      if (testDiscs) {
+         hit |= _mm512_cmp_ps_mask(distanceSquared, satelliteRadiusSquared, _CMP_LT_OQ);
+      }
+      __m512 weight = _mm512_div_ps(one, _mm512_mul_ps(distanceSquared, distanceSquared));
+      __m512 red = _mm512_set1_ps(sats[j].identifier.red);
+      __m512 green = _mm512_set1_ps(sats[j].identifier.green);
+      __m512 blue = _mm512_set1_ps(sats[j].identifier.blue);
+      weights = _mm512_add_ps(weights, weight);
+      rr = _mm512_add_ps(rr, _mm512_mul_ps(red, weight));
+      rg = _mm512_add_ps(rg, _mm512_mul_ps(green, weight));
+      rb = _mm512_add_ps(rb, _mm512_mul_ps(blue, weight));
+      __mmask16 closer = _mm512_cmp_ps_mask(distanceSquared, shortest, _CMP_LT_OQ);
+      shortest = _mm512_mask_mov_ps(shortest, closer, distanceSquared);
+      nr = _mm512_mask_mov_ps(nr, closer, red);
+      ng = _mm512_mask_mov_ps(ng, closer, green);
+      nb = _mm512_mask_mov_ps(nb, closer, blue);
+      if (testDiscs && (__mmask16)(hit | blackHole) == 0xffff) {
+         break; // Every lane is decided
+      }
+   }
+   const __m512 three = _mm512_set1_ps(3.0f);
+   const __m512 scale = _mm512_set1_ps(255.0f);
+   __m512 red = _mm512_add_ps(nr, _mm512_div_ps(_mm512_mul_ps(rr, three), weights));
+   __m512 green = _mm512_add_ps(ng, _mm512_div_ps(_mm512_mul_ps(rg, three), weights));
+   __m512 blue = _mm512_add_ps(nb, _mm512_div_ps(_mm512_mul_ps(rb, three), weights));
+   if (testDiscs) {
+      red = _mm512_mask_mov_ps(_mm512_mask_mov_ps(red, hit, one), blackHole, zero);
+      green = _mm512_mask_mov_ps(_mm512_mask_mov_ps(green, hit, one), blackHole, zero);
+      blue = _mm512_mask_mov_ps(_mm512_mask_mov_ps(blue, hit, one), blackHole, zero);
+   }
+   __m512i bgr = _mm512_or_si512(
+      _mm512_or_si512(_mm512_slli_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(red, scale)), 16),
+                      _mm512_slli_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(green, scale)), 8)),
+      _mm512_cvttps_epi32(_mm512_mul_ps(blue, scale)));
+   _mm512_storeu_si512(out, bgr);
+}
+
+// Pixels x0 up to x1 of row y in blocks of 8, returns the first column
+// left over. The two loops inline shadeAvx2 with a constant testDiscs.
+SIMD_TARGET_AVX2
+static int shadeRowAvx2(const satellite *sats, int count, int x0, int x1, int y,
+                        int mouseX, int mouseY, color_u8 *row, int testDiscs){
+   int x = x0;
+   if (testDiscs) {
+      for (; x + 8 <= x1; x += 8) {
+         shadeAvx2(sats, count, x, y, mouseX, mouseY, row + x, 1);
+      }
+   } else {
+      for (; x + 8 <= x1; x += 8) {
+         shadeAvx2(sats, count, x, y, mouseX, mouseY, row + x, 0);
+      }
+   }
+   return x;
+}
+
+// Pixels x0 up to x1 of row y in blocks of 16, as shadeRowAvx2
+SIMD_TARGET_AVX512
+static int shadeRowAvx512(const satellite *sats, int count, int x0, int x1, int y,
+                          int mouseX, int mouseY, color_u8 *row, int testDiscs){
+   int x = x0;
+   if (testDiscs) {
+      for (; x + 16 <= x1; x += 16) {
+         shadeAvx512(sats, count, x, y, mouseX, mouseY, row + x, 1);
+      }
+   } else {
+      for (; x + 16 <= x1; x += 16) {
+         shadeAvx512(sats, count, x, y, mouseX, mouseY, row + x, 0);
+      }
+   }
+   return x;
+}
+#endif
+
+// Tiles of --tile, 1 when a satellite or the black hole may cover one of
+// their pixels. Rebuilt every frame.
+static unsigned char *tileTouched = NULL;
+static int tileCapacity = 0;
+// Tiles and touched tiles of the last frame
+static int lastTiles = 0, lastTouchedTiles = 0;
+
+// Marks the tiles the disc of radius around (x, y) may touch. One pixel
+// of margin covers the rounding of the float distances.
+static void markDisc(float x, float y, float radius, int tile, int tilesX, int tilesY){
+   float left = x - radius - 1.0f, right = x + radius + 1.0f;
+   float top = y - radius - 1.0f, bottom = y + radius + 1.0f;
+   // Also false for NaN positions, which never hit
+   if (!(right >= 0.0f && left <= windowWidth - 1 && bottom >= 0.0f && top <= windowHeight - 1)) {
+      return;
+   }
+   int x0 = left < 0.0f ? 0 : (int)left / tile;
+   int x1 = right >= windowWidth - 1 ? tilesX - 1 : (int)right / tile;
+   int y0 = top < 0.0f ? 0 : (int)top / tile;
+   int y1 = bottom >= windowHeight - 1 ? tilesY - 1 : (int)bottom / tile;
+   for (int ty = y0; ty <= y1; ++ty) {
+      for (int tx = x0; tx <= x1; ++tx) {
+         tileTouched[ty * tilesX + tx] = 1;
+      }
+   }
+}
+
+// Rendering loop with --tile. Only the touched tiles test the black hole
+// and the satellite discs.
+static void simdTiledRun(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out,
+                         int stride){
+   const int level = simdLevel();
+   const int tile = graphicsTileSize;
+   const int tilesX = (windowWidth + tile - 1) / tile;
+   const int tilesY = (windowHeight + tile - 1) / tile;
+   const int tiles = tilesX * tilesY;
+   if (tiles > tileCapacity) {
+      free(tileTouched);
+      tileTouched = (unsigned char*)malloc(tiles);
+      if (!tileTouched) {
+         printf("Out of memory for %d tiles\n", tiles);
+         exit(-1);
+      }
+      tileCapacity = tiles;
+   }
+   memset(tileTouched, 0, tiles);
+   markDisc(mouseX, mouseY, BLACK_HOLE_RADIUS, tile, tilesX, tilesY);
+   for (int j = 0; j < count; ++j) {
+      markDisc(sats[j].position.x, sats[j].position.y, SATELLITE_RADIUS, tile, tilesX, tilesY);
+   }
+   int touched = 0;
+   for (int t = 0; t < tiles; ++t) {
+      touched += tileTouched[t];
+   }
+   lastTiles = tiles;
+   lastTouchedTiles = touched;
+
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkTiles = 0;
+   int t;
+   #pragma omp for schedule(static) nowait
+   for (t = 0; t < tiles; ++t) {
+      chunkTiles++;
+      const int x0 = t % tilesX * tile;
+      const int y0 = t / tilesX * tile;
+      const int x1 = x0 + tile < windowWidth ? x0 + tile : windowWidth;
+      const int y1 = y0 + tile < windowHeight ? y0 + tile : windowHeight;
+      const int full = tileTouched[t];
+      for (int h = y0; h < y1; ++h) {
+         color_u8 *row = out + (size_t)h * stride;
+         int w = x0;
+#ifdef HAVE_SIMD_X86
+         if (level == SIMD_AVX512) {
+            w = shadeRowAvx512(sats, count, w, x1, h, mouseX, mouseY, row, full);
+         } else if (level == SIMD_AVX2) {
+            w = shadeRowAvx2(sats, count, w, x1, h, mouseX, mouseY, row, full);
+         }
+#endif
+         for (; w < x1; ++w) {
+            row[w] = shadeScalar(sats, count, w, h, mouseX, mouseY);
+         }
+      }
+   }
+   if (chunkStart) {
+      traceSpan("graphics tiles", "simd", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "tiles", chunkTiles);
+   }
+   }
+}
+
+// Rendering loop (This is called once a frame after physics engine)
+static void simdGraphicsRun(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out,
+                            int stride){
+   if (graphicsTileSize > 0) {
+      simdTiledRun(sats, count, mouseX, mouseY, out, stride);
+      return;
+   }
+   const int level = simdLevel();
+
+   const int traceRows = traceOpenmpRows();
+   #pragma omp parallel
+   {
+   uint64_t chunkStart = traceEnabled() ? timingNow() : 0;
+   int chunkRows = 0;
+   int h;
+   #pragma omp for schedule(static) nowait
+   for (h = 0; h < windowHeight; ++h) {
+      chunkRows++;
+      color_u8 *row = out + (size_t)h * stride;
+      int w = 0;
+#ifdef HAVE_SIMD_X86
+      if (level == SIMD_AVX512) {
+         w = shadeRowAvx512(sats, count, w, windowWidth, h, mouseX, mouseY, row, 1);
+      } else if (level == SIMD_AVX2) {
+         w = shadeRowAvx2(sats, count, w, windowWidth, h, mouseX, mouseY, row, 1);
+      }
+#endif
+      for (; w < windowWidth; ++w) {
+         row[w] = shadeScalar(sats, count, w, h, mouseX, mouseY);
+      }
+   }
+   if (chunkStart) {
+      traceSpan("graphics chunk", "simd", traceOpenmpThread(traceRows), chunkStart, timingNow(),
+                "rows", chunkRows);
+   }
+   }
+}
+
+static void simdGraphicsInit(void){
+   int level = simdLevel();
+   printf("SIMD graphics: %s, %d pixels per instruction\n", simdName(level),
+          level == SIMD_AVX512 ? 16 : level == SIMD_AVX2 ? 8 : 1);
+   if (graphicsTileSize > 0) {
+      printf("SIMD graphics in tiles of %dx%d pixels\n", graphicsTileSize, graphicsTileSize);
+   }
+}
+
+static void simdGraphicsDestroy(void){
+   if (lastTiles) {
+      printf("SIMD graphics: %d of %d tiles touched by a satellite or the black hole in the last frame\n",
+             lastTouchedTiles, lastTiles);
+   }
+   free(tileTouched);
+   tileTouched = NULL;
+   tileCapacity = 0;
+   lastTiles = lastTouchedTiles = 0;
+}
+
+const GraphicsEngine simdGraphics = {
+   .name = "simd",
+   .init = simdGraphicsInit,
+   .destroy = simdGraphicsDestroy,
+   .run = simdGraphicsRun
+};
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ensemble.h"
+#include "integrator.h"
+#include "timing.h"
+#include "trace.h"
+#include "validation.h"
+
+// The system at index system of the batch
+static satellite *systemAt(satellite *batch, int system){
+   return batch + (size_t)system * satelliteCount;
+}
+
+static int writeStates(const char *path, const satellite *batch, int systems,
+                       unsigned int firstSeed){
+   FILE *f = fopen(path, "w");
+   if (!f) {
+      printf("Cannot write ensemble states: %s\n", path);
+      return -1;
+   }
+   fprintf(f, "system,seed,satellite,position_x,position_y,velocity_x,velocity_y\n");
+   for (int s = 0; s < systems; ++s) {
+      for (int i = 0; i < satelliteCount; ++i) {
+         const satellite *sat = &batch[(size_t)s * satelliteCount + i];
+         fprintf(f, "%d,%u,%d,%.9g,%.9g,%.9g,%.9g\n", s, firstSeed + s, i,
+                 sat->position.x, sat->position.y, sat->velocity.x, sat->velocity.y);
+      }
+   }
+   fclose(f);
+   printf("Final states written to %s\n", path);
+   return 0;
+}
+
+int runEnsemble(const PhysicsEngine *engine, int systems, unsigned int firstSeed,
+                int frames, double tolerance, const char *outputPath){
+   size_t total = (size_t)systems * satelliteCount;
+   if (total > (size_t)2147483647) {
+      printf("Too many satellites in the ensemble: %zu\n", total);
+      return 1;
+   }
+   satellite *batch = (satellite*)alignedAlloc(sizeof(satellite) * total);
+   // The first and the last system, moved by the reference
+   satellite *reference = (satellite*)alignedAlloc(sizeof(satellite) * satelliteCount * 2);
+   if (!batch || !reference) {
+      printf("Out of memory for an ensemble of %d x %d satellites\n", systems, satelliteCount);
+      exit(-1);
+   }
+   for (int s = 0; s < systems; ++s) {
+      srand(firstSeed + s);
+      createSatellites(systemAt(batch, s), satelliteCount);
+   }
+   memcpy(reference, systemAt(batch, 0), sizeof(satellite) * satelliteCount);
+   memcpy(reference + satelliteCount, systemAt(batch, systems - 1),
+          sizeof(satellite) * satelliteCount);
+
+   printf("Ensemble of %d systems x %d satellites (seeds %u..%u), %d frames of %d %s substeps\n",
+          systems, satelliteCount, firstSeed, firstSeed + systems - 1, frames,
+          physicsUpdatesPerFrame, integratorName(integrator));
+
+   TimingHistogram physicsTiming;
+   timingReset(&physicsTiming);
+   long long evaluations = 0;
+   ValidationReport report;
+   validationReset(&report);
+   report.satelliteTolerance = tolerance;
+
+   for (int frame = 0; frame < frames; ++frame) {
+      uint64_t start = timingNow();
+      frameForceEvaluations = 0;
+      engine->run(batch, (int)total, HORIZONTAL_CENTER, VERTICAL_CENTER);
+      uint64_t end = timingNow();
+      timingRecord(&physicsTiming, end - start);
+      traceSpan("ensemble physics", "stage", TRACE_TID_MAIN, start, end, "frame", frame);
+      evaluations += frameForceEvaluations;
+
+      if (frame == 0) {
+         sequentialPhysicsEngine(reference, satelliteCount * 2, HORIZONTAL_CENTER, VERTICAL_CENTER);
+         validationCompareSatellites(&report, reference, systemAt(batch, 0),
+                                     satelliteCount, 0);
+         validationCompareSatellites(&report, reference + satelliteCount,
+                                     systemAt(batch, systems - 1), satelliteCount, 0);
+      }
+   }
+
+   double seconds = physicsTiming.sum / 1e9;
+   double steps = (double)total * physicsUpdatesPerFrame * frames;
+   printf("Physics %.3f s, %.3g satellite steps per second", seconds,
+          seconds > 0.0 ? steps / seconds : 0.0);
+   if (evaluations > 0) {
+      printf(", %.3g force evaluations per second", seconds > 0.0 ? evaluations / seconds : 0.0);
+   }
+   printf("\n");
+   timingPrint("ensemble frame", &physicsTiming);
+   validationPrint("Correctness of the first and last system", &report);
+
+   int exitCode = validationPassed(&report) ? 0 : 2;
+   if (outputPath[0] && writeStates(outputPath, batch, systems, firstSeed)) {
+      exitCode = 1;
+   }
+
+   printf("{\"physics\":\"%s\",\"ensemble\":%d,\"satellites\":%d,\"substeps\":%d,"
+          "\"integrator\":\"%s\",\"frames\":%d,\"physics_ms\":%.3f,"
+          "\"satellite_steps_per_s\":%.6g,\"force_evaluations_per_s\":%.6g,\"stages\":{",
+          engine->name, systems, satelliteCount, physicsUpdatesPerFrame,
+          integratorName(integrator), frames, physicsTiming.sum / 1e6,
+          seconds > 0.0 ? steps / seconds : 0.0,
+          seconds > 0.0 ? evaluations / seconds : 0.0);
+   timingPrintJson(stdout, "physics", &physicsTiming);
+   printf("},\"accuracy\":");
+   validationPrintJson(stdout, &report);
+   printf("}\n");
+
+   alignedFree(batch);
+   alignedFree(reference);
+   return exitCode;
+}
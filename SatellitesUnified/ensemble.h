@@ -0,0 +1,25 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Ensemble of independent systems ¤¤                           //
+//                                                                    //
+//    --ensemble K creates K systems of satelliteCount satellites     //
+//    from K consecutive seeds, one after another in one array. The   //
+//    satellites do not affect each other, so one physics call moves  //
+//    all systems: the SIMD lanes and OpenCL work-items span systems. //
+//    No window or graphics, the result is the throughput in          //
+//    satellite steps per second and the final state of every system. //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "satellites.h"
+
+// Runs systems systems, seeded firstSeed, firstSeed + 1, ..., for frames
+// frames with engine around the window center. The first frame of the
+// first and of the last system is compared to the reference within
+// tolerance. Writes the final states as CSV to outputPath unless it is
+// empty. Returns the exit code, 2 when the check failed.
+int runEnsemble(const PhysicsEngine *engine, int systems, unsigned int firstSeed,
+                int frames, double tolerance, const char *outputPath);
+
+#endif // ENSEMBLE_H
@@ -0,0 +1,317 @@
+#include "integrator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+int integrator = INTEGRATOR_EULER;
+double adaptiveEta = 0.0;
+long long frameForceEvaluations = 0;
+
+static const char *integratorNames[INTEGRATOR_COUNT] = {
+   "euler", "verlet", "yoshida4"
+};
+
+int integratorFromName(const char *name){
+   for (int i = 0; i < INTEGRATOR_COUNT; ++i) {
+      if (!strcmp(integratorNames[i], name)) {
+         return i;
+      }
+   }
+   // Forest and Ruth found the same method as Yoshida
+   if (!strcmp(name, "forest-ruth")) {
+      return INTEGRATOR_YOSHIDA4;
+   }
+   return -1;
+}
+
+const char *integratorName(int method){
+   return method >= 0 && method < INTEGRATOR_COUNT ? integratorNames[method] : "unknown";
+}
+
+long long integratorForceEvaluations(int method, int substeps){
+   switch (method) {
+   case INTEGRATOR_VERLET:
+      // The force at the end of a step is reused at the start of the next
+      return (long long)substeps + 1;
+   case INTEGRATOR_YOSHIDA4:
+      return 3ll * substeps;
+   default:
+      return substeps;
+   }
+}
+
+// Gravity of the black hole at (mouseX, mouseY) on a satellite at position
+static inline doublevector gravityAt(doublevector position, int mouseX, int mouseY){
+   doublevector positionToBlackHole = {.x = position.x - mouseX,
+                                       .y = position.y - mouseY};
+   double distToBlackHoleSquared =
+      positionToBlackHole.x * positionToBlackHole.x +
+      positionToBlackHole.y * positionToBlackHole.y;
+   double distToBlackHole = sqrt(distToBlackHoleSquared);
+   double accumulation = GRAVITY / distToBlackHoleSquared;
+   doublevector acceleration = {
+      .x = -accumulation * (positionToBlackHole.x / distToBlackHole),
+      .y = -accumulation * (positionToBlackHole.y / distToBlackHole)};
+   return acceleration;
+}
+
+// Yoshida weights, w1 = 1 / (2 - 2^(1/3)) and w0 = -2^(1/3) * w1
+#define YOSHIDA_W1 1.3512071919596578
+#define YOSHIDA_W0 -1.7024143839193155
+
+// One kick - drift - kick step of h. a is the force at p on entry and at
+// the new p on return, so consecutive steps evaluate the force only once.
+static inline void verletStep(doublevector *p, doublevector *v, doublevector *a,
+                              double h, int mouseX, int mouseY){
+   v->x += a->x * (0.5 * h);
+   v->y += a->y * (0.5 * h);
+   p->x += v->x * h;
+   p->y += v->y * h;
+   *a = gravityAt(*p, mouseX, mouseY);
+   v->x += a->x * (0.5 * h);
+   v->y += a->y * (0.5 * h);
+}
+
+// One Yoshida step of h: three Verlet steps of w1, w0 and w1 times h,
+// as drift - kick - drift - kick - drift - kick - drift
+static inline void yoshidaStep(doublevector *p, doublevector *v,
+                               double h, int mouseX, int mouseY){
+   const double drift[4] = {0.5 * YOSHIDA_W1 * h, 0.5 * (YOSHIDA_W0 + YOSHIDA_W1) * h,
+                            0.5 * (YOSHIDA_W0 + YOSHIDA_W1) * h, 0.5 * YOSHIDA_W1 * h};
+   const double kick[3] = {YOSHIDA_W1 * h, YOSHIDA_W0 * h, YOSHIDA_W1 * h};
+   for (int k = 0; k < 3; ++k) {
+      p->x += v->x * drift[k];
+      p->y += v->y * drift[k];
+      doublevector a = gravityAt(*p, mouseX, mouseY);
+      v->x += a.x * kick[k];
+      v->y += a.y * kick[k];
+   }
+   p->x += v->x * drift[3];
+   p->y += v->y * drift[3];
+}
+
+void integrateSatelliteSpan(doublevector *position, doublevector *velocity,
+                            int mouseX, int mouseY, double duration, int steps, int method){
+   doublevector p = *position;
+   doublevector v = *velocity;
+   const double h = duration / steps;
+
+   if (method == INTEGRATOR_VERLET) {
+      doublevector a = gravityAt(p, mouseX, mouseY);
+      for (int s = 0; s < steps; ++s) {
+         verletStep(&p, &v, &a, h, mouseX, mouseY);
+      }
+   } else if (method == INTEGRATOR_YOSHIDA4) {
+      for (int s = 0; s < steps; ++s) {
+         yoshidaStep(&p, &v, h, mouseX, mouseY);
+      }
+   } else {
+      for (int s = 0; s < steps; ++s) {
+         doublevector a = gravityAt(p, mouseX, mouseY);
+         v.x += a.x * h;
+         v.y += a.y * h;
+         p.x += v.x * h;
+         p.y += v.y * h;
+      }
+   }
+   *position = p;
+   *velocity = v;
+}
+
+void integrateSatellite(doublevector *position, doublevector *velocity,
+                        int mouseX, int mouseY, int substeps, int method){
+   doublevector p = *position;
+   doublevector v = *velocity;
+
+   if (method != INTEGRATOR_EULER) {
+      integrateSatelliteSpan(&p, &v, mouseX, mouseY, DELTATIME, substeps, method);
+   } else {
+      // Same expressions as the reference code, velocity first
+      for (int s = 0; s < substeps; ++s) {
+         doublevector positionToBlackHole = {.x = p.x - mouseX,
+                                             .y = p.y - mouseY};
+         double distToBlackHoleSquared =
+            positionToBlackHole.x * positionToBlackHole.x +
+            positionToBlackHole.y * positionToBlackHole.y;
+         double distToBlackHole = sqrt(distToBlackHoleSquared);
+         doublevector normalizedDirection = {
+            .x = positionToBlackHole.x / distToBlackHole,
+            .y = positionToBlackHole.y / distToBlackHole};
+         double accumulation = GRAVITY / distToBlackHoleSquared;
+         v.x -= accumulation * normalizedDirection.x * DELTATIME / substeps;
+         v.y -= accumulation * normalizedDirection.y * DELTATIME / substeps;
+         p.x += v.x * DELTATIME / substeps;
+         p.y += v.y * DELTATIME / substeps;
+      }
+   }
+   *position = p;
+   *velocity = v;
+}
+
+long long integrateSatelliteAdaptive(doublevector *position, doublevector *velocity,
+                                     int mouseX, int mouseY, double eta,
+                                     int maxSubsteps, int method){
+   doublevector p = *position;
+   doublevector v = *velocity;
+   doublevector a = {.x = 0.0, .y = 0.0};
+   const double minStep = (double)DELTATIME / maxSubsteps;
+   double remaining = DELTATIME;
+   long long evaluations = 0;
+
+   if (method == INTEGRATOR_VERLET) {
+      a = gravityAt(p, mouseX, mouseY);
+      evaluations++;
+   }
+   while (remaining > 0.0) {
+      // Orbital time scale sqrt(r^3 / GM) at the current distance
+      double dx = p.x - mouseX;
+      double dy = p.y - mouseY;
+      double distToBlackHole = sqrt(dx * dx + dy * dy);
+      double h = eta * distToBlackHole * sqrt(distToBlackHole / GRAVITY);
+      if (!(h > minStep)) {
+         h = minStep; // Also when the satellite is in the singularity
+      }
+      if (h >= remaining) {
+         h = remaining;
+      }
+
+      if (method == INTEGRATOR_VERLET) {
+         verletStep(&p, &v, &a, h, mouseX, mouseY);
+         evaluations++;
+      } else if (method == INTEGRATOR_YOSHIDA4) {
+         yoshidaStep(&p, &v, h, mouseX, mouseY);
+         evaluations += 3;
+      } else {
+         a = gravityAt(p, mouseX, mouseY);
+         v.x += a.x * h;
+         v.y += a.y * h;
+         p.x += v.x * h;
+         p.y += v.y * h;
+         evaluations++;
+      }
+      remaining -= h;
+   }
+   *position = p;
+   *velocity = v;
+   return evaluations;
+}
+
+
+////////////////////////////////////////////////
+// ¤¤ Calibration (--calibrate) ¤¤            //
+////////////////////////////////////////////////
+
+// Runs frames frames of every satellite with the black hole in the center.
+// The state is stored as float between the frames like in the engines.
+// Positions of frame f go to positions[f*count ... f*count+count-1].
+static void runFrames(const satellite *initial, int count, int frames,
+                      int substeps, int method, floatvector *positions){
+   int i;
+   #pragma omp parallel for schedule(dynamic, 1)
+   for (i = 0; i < count; ++i) {
+      floatvector position = initial[i].position;
+      floatvector velocity = initial[i].velocity;
+      for (int f = 0; f < frames; ++f) {
+         doublevector p = {.x = position.x, .y = position.y};
+         doublevector v = {.x = velocity.x, .y = velocity.y};
+         integrateSatellite(&p, &v, HORIZONTAL_CENTER, VERTICAL_CENTER, substeps, method);
+         position.x = p.x;
+         position.y = p.y;
+         velocity.x = v.x;
+         velocity.y = v.y;
+         positions[f * count + i] = position;
+      }
+   }
+}
+
+// Largest distance between two runs over all frames and satellites
+static double maxDistance(const floatvector *a, const floatvector *b, int n){
+   double worst = 0.0;
+   for (int i = 0; i < n; ++i) {
+      double dx = (double)a[i].x - b[i].x;
+      double dy = (double)a[i].y - b[i].y;
+      double distance = sqrt(dx * dx + dy * dy);
+      // NaN never passes
+      if (!(distance <= worst)) {
+         worst = isnan(distance) ? INFINITY : distance;
+      }
+   }
+   return worst;
+}
+
+int calibrateIntegrators(const satellite *initial, int count, int frames, double tolerance){
+   int n = count * frames;
+   floatvector *reference = (floatvector*)alignedAlloc(sizeof(floatvector) * n);
+   floatvector *candidate = (floatvector*)alignedAlloc(sizeof(floatvector) * n);
+   if (!reference || !candidate) {
+      printf("Out of memory for %d satellites\n", count);
+      exit(-1);
+   }
+
+   printf("Calibrating against %d Euler substeps over %d frames, tolerance %g px\n",
+          referenceUpdatesPerFrame, frames, tolerance);
+   runFrames(initial, count, frames, referenceUpdatesPerFrame, INTEGRATOR_EULER, reference);
+
+   int substeps[INTEGRATOR_COUNT];
+   double errors[INTEGRATOR_COUNT];
+   for (int method = 0; method < INTEGRATOR_COUNT; ++method) {
+      // Double until the tolerance is met, then bisect between the last
+      // failing and the first passing count
+      int failing = 0;
+      int passing = 1;
+      double passingError;
+      for (;;) {
+         runFrames(initial, count, frames, passing, method, candidate);
+         passingError = maxDistance(reference, candidate, n);
+         if (passingError <= tolerance || passing >= 1000000000 / 2) {
+            break;
+         }
+         failing = passing;
+         passing *= 2;
+      }
+      while (passingError <= tolerance && passing - failing > 1) {
+         int middle = failing + (passing - failing) / 2;
+         runFrames(initial, count, frames, middle, method, candidate);
+         double error = maxDistance(reference, candidate, n);
+         if (error <= tolerance) {
+            passing = middle;
+            passingError = error;
+         } else {
+            failing = middle;
+         }
+      }
+      substeps[method] = passingError <= tolerance ? passing : 0;
+      errors[method] = passingError;
+
+      long long evaluations = integratorForceEvaluations(method, passing);
+      if (substeps[method]) {
+         printf("%-9s %10d substeps %12lld force evaluations per satellite and frame, "
+                "max error %.3g px, %.1fx fewer than the reference\n",
+                integratorName(method), passing, evaluations, passingError,
+                (double)referenceUpdatesPerFrame / evaluations);
+      } else {
+         printf("%-9s does not reach the tolerance\n", integratorName(method));
+      }
+   }
+
+   // One JSON line for scripts
+   printf("{\"calibration\":{\"tolerance_px\":%g,\"frames\":%d,\"satellites\":%d,"
+          "\"reference_substeps\":%d,\"integrators\":[",
+          tolerance, frames, count, referenceUpdatesPerFrame);
+   for (int method = 0; method < INTEGRATOR_COUNT; ++method) {
+      printf("%s{\"name\":\"%s\",", method ? "," : "", integratorName(method));
+      if (substeps[method]) {
+         printf("\"substeps\":%d,\"force_evaluations\":%lld,\"max_error_px\":%g}",
+                substeps[method], integratorForceEvaluations(method, substeps[method]),
+                errors[method]);
+      } else {
+         printf("\"substeps\":null,\"force_evaluations\":null,\"max_error_px\":null}");
+      }
+   }
+   printf("]}}\n");
+
+   alignedFree(reference);
+   alignedFree(candidate);
+   return 0;
+}
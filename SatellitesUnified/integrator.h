@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Integrators of the satellite orbits ¤¤                       //
+//                                                                    //
+//    euler     semi-implicit Euler, the reference (1st order)        //
+//    verlet    velocity Verlet / leapfrog (2nd order)                //
+//    yoshida4  Yoshida / Forest-Ruth (4th order), alias forest-ruth  //
+//                                                                    //
+//    All of them are symplectic, so the orbits do not spiral in or   //
+//    out. The higher orders reach the accuracy of the Euler          //
+//    reference with far fewer substeps, see --calibrate.             //
+//                                                                    //
+//    --adaptive steps by eta * sqrt(r^3 / GM) from the distance r at //
+//    the start of each step, never below DELTATIME / maxSubsteps,    //
+//    and shortens the last step to end on DELTATIME.                 //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include "satellites.h"
+
+typedef enum {
+   INTEGRATOR_EULER,
+   INTEGRATOR_VERLET,
+   INTEGRATOR_YOSHIDA4,
+   INTEGRATOR_COUNT
+} Integrator;
+
+// Allowed distance from the Euler reference after one frame, in pixels,
+// when a higher order integrator is used with fewer substeps
+#define INTEGRATOR_TOLERANCE 0.05
+
+// Integrator of the sequential, openmp and opencl physics (--integrator)
+extern int integrator;
+// Step size factor of --adaptive, 0 uses physicsUpdatesPerFrame equal steps
+extern double adaptiveEta;
+// Force evaluations of all satellites in the last physics call, set by
+// the engines that integrate step by step (0 for the others)
+extern long long frameForceEvaluations;
+
+// Integrator with the given name, -1 when there is none
+int integratorFromName(const char *name);
+const char *integratorName(int method);
+// Gravity evaluations of one satellite in one frame
+long long integratorForceEvaluations(int method, int substeps);
+
+// Moves one satellite by DELTATIME in substeps steps of method around the
+// black hole at (mouseX, mouseY). The euler method gives bit by bit the
+// same result as the reference code.
+void integrateSatellite(doublevector *position, doublevector *velocity,
+                        int mouseX, int mouseY, int substeps, int method);
+
+// Moves one satellite by duration in the given number of equal steps of
+// method. Unlike integrateSatellite(), euler is not bit exact here.
+void integrateSatelliteSpan(doublevector *position, doublevector *velocity,
+                            int mouseX, int mouseY, double duration, int steps, int method);
+
+// Moves one satellite by DELTATIME with steps of eta * sqrt(r^3 / GM),
+// where r is the distance to the black hole at the start of the step.
+// Close to the black hole the steps are short, far away they are long,
+// but never shorter than DELTATIME / maxSubsteps. The step size changes
+// along the orbit, so the result is only close to the reference, not
+// symplectic. Returns the force evaluations.
+long long integrateSatelliteAdaptive(doublevector *position, doublevector *velocity,
+                                     int mouseX, int mouseY, double eta,
+                                     int maxSubsteps, int method);
+
+// Finds the smallest substep count of every integrator that stays within
+// tolerance pixels of the Euler reference (referenceUpdatesPerFrame
+// substeps) over frames frames, starting from the given satellites.
+// Prints a table and a JSON line, returns 0.
+int calibrateIntegrators(const satellite *initial, int count, int frames, double tolerance);
+
+#endif // INTEGRATOR_H
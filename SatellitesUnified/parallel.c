@@ -0,0 +1,1561 @@
+/* COMP.CE.350 Parallelization Excercise 2024
+   Copyright (c) 2016 Matias Koskela matias.koskela@tut.fi
+                      Heikki Kultala heikki.kultala@tut.fi
+                      Topi Leppanen  topi.leppanen@tuni.fi
+
+VERSION 1.1 - updated to not have stuck satellites so easily
+VERSION 1.2 - updated to not have stuck satellites hopefully at all.
+VERSION 19.0 - make all satellites affect the color with weighted average.
+               add physic correctness check.
+VERSION 20.0 - relax physic correctness check
+VERSION 24.0 - port to SDL2
+VERSION 25.0 - add macOS support
+*/
+
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Unified version, engines selected at runtime ¤¤              //
+//                                                                    //
+//    --physics  sequential | openmp | simd | parareal | kepler |     //
+//               opencl                                               //
+//    --graphics sequential | openmp | simd | opencl                  //
+//    --integrator euler | verlet | yoshida4                          //
+//                                                                    //
+//    The engines live in engine_*.c, this file has the frame loop,   //
+//    the sequential reference code and the error checks              //
+////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <ctype.h> // isspace
+#include <float.h> // DBL_MIN
+#include <stdio.h> // printf
+#include <math.h> // INFINITY
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "ensemble.h"
+#include "integrator.h"
+#include "pipeline.h"
+#include "sampler.h"
+#include "satellites.h"
+#include "simd.h"
+#include "speculate.h"
+#include "timing.h"
+#include "trace.h"
+#include "trajectory.h"
+#include "validation.h"
+
+int mousePosX;
+int mousePosY;
+
+// Sizes in use (satellites.h), set from the command line or a config file
+int windowWidth = DEFAULT_WINDOW_WIDTH;
+int windowHeight = DEFAULT_WINDOW_HEIGHT;
+int satelliteCount = DEFAULT_SATELLITE_COUNT;
+int physicsUpdatesPerFrame = DEFAULT_PHYSICSUPDATESPERFRAME;
+int referenceUpdatesPerFrame = 0; // 0 until set in main()
+int graphicsTileSize = 0;
+
+// Pixel buffer which is rendered to the screen
+color_u8* pixels;
+// Where the graphics of the current frame go, rows frameStride pixels
+// apart: pixels, or the window surface itself (--zero-copy)
+color_u8* frameTarget;
+int frameStride;
+
+// Pixel buffer which is used for error checking
+color_u8* correctPixels;
+
+// Buffer for all satellites in the space
+satellite* satellites;
+satellite* backupSatelites;
+
+// Engines that can be selected with --physics and --graphics
+static const PhysicsEngine *physicsEngines[] = {
+   &sequentialPhysics,
+   &openmpPhysics,
+   &simdPhysics,
+   &pararealPhysics,
+   &keplerPhysics,
+#ifdef HAVE_OPENCL
+   &openclPhysics,
+#endif
+};
+static const GraphicsEngine *graphicsEngines[] = {
+   &sequentialGraphics,
+   &openmpGraphics,
+   &simdGraphics,
+#ifdef HAVE_OPENCL
+   &openclGraphics,
+#endif
+};
+#define PHYSICS_ENGINE_COUNT (int)(sizeof(physicsEngines) / sizeof(physicsEngines[0]))
+#define GRAPHICS_ENGINE_COUNT (int)(sizeof(graphicsEngines) / sizeof(graphicsEngines[0]))
+
+// The selected engines, OpenMP unless told otherwise
+const PhysicsEngine *physicsEngine = &openmpPhysics;
+const GraphicsEngine *graphicsEngine = &openmpGraphics;
+
+static const PhysicsEngine *findPhysicsEngine(const char *name){
+   for (int i = 0; i < PHYSICS_ENGINE_COUNT; ++i) {
+      if (!strcmp(physicsEngines[i]->name, name)) {
+         return physicsEngines[i];
+      }
+   }
+   return NULL;
+}
+
+static const GraphicsEngine *findGraphicsEngine(const char *name){
+   for (int i = 0; i < GRAPHICS_ENGINE_COUNT; ++i) {
+      if (!strcmp(graphicsEngines[i]->name, name)) {
+         return graphicsEngines[i];
+      }
+   }
+   return NULL;
+}
+
+static void printEngines(void){
+   printf("Physics engines:");
+   for (int i = 0; i < PHYSICS_ENGINE_COUNT; ++i) {
+      printf(" %s", physicsEngines[i]->name);
+   }
+   printf("\nGraphics engines:");
+   for (int i = 0; i < GRAPHICS_ENGINE_COUNT; ++i) {
+      printf(" %s", graphicsEngines[i]->name);
+   }
+   printf("\n");
+}
+
+// OpenMP threads of the speculative physics (--speculate), 0 disables it
+int speculateThreads = 0;
+// Frames in flight (--pipeline), 1 runs the stages one after another
+int pipelineDepth = 1;
+
+void init(){
+   physicsEngine->init();
+   graphicsEngine->init();
+   speculateInit(physicsEngine, speculateThreads);
+}
+
+// Physics engine loop. (This is called once a frame before graphics engine)
+void parallelPhysicsEngine(){
+   physicsEngine->run(satellites, satelliteCount, mousePosX, mousePosY);
+}
+
+// Rendering loop (This is called once a frame after physics engine)
+void parallelGraphicsEngine(){
+   graphicsEngine->run(satellites, satelliteCount, mousePosX, mousePosY, frameTarget, frameStride);
+}
+
+void destroy(){
+   graphicsEngine->destroy();
+   physicsEngine->destroy();
+}
+
+
+
+
+
+
+
+////////////////////////////////////////////////
+// ¤¤ Frame loop and reference code ¤¤        //
+////////////////////////////////////////////////
+
+SDL_Window* win;
+SDL_Surface* surf;
+// Draw straight into the window surface after the checked frames
+// (--zero-copy), and whether the surface allows it
+int zeroCopy = 1;
+static int surfaceDirect = 0;
+// Is used to find out frame times, all in nanoseconds (timing.h)
+TimingHistogram physicsTiming, graphicsTiming, presentTiming, validationTiming, frameTiming;
+uint64_t previousFinishTime = 0;
+// Start of the first frame, for the trajectory timestamps
+uint64_t firstFrameTime = 0;
+unsigned int frameNumber = 0;
+unsigned int seed = 0;
+// Frames to run without a window (--headless), 0 means interactive mode
+unsigned int headlessFrames = 0;
+// Differences to the sequential reference code, and where to write them (--report)
+ValidationReport validationReport;
+char reportPath[512] = "";
+// Sampled checks of the later frames (--sample-every, --sample-pixels)
+unsigned int sampleEvery = 0;
+int samplePixels = 256;
+// Independent systems of --ensemble, 0 runs the simulation instead, and
+// the file for their final states (--ensemble-output)
+int ensembleSystems = 0;
+char ensemblePath[512] = "";
+// Position tolerance for --calibrate, 0 runs the simulation instead
+double calibrationTolerance = 0.0;
+// Checkpoint file and interval in frames (--checkpoint, --checkpoint-every),
+// the checkpoint to resume from (--restore) and the frame to reach with
+// physics only (--fast-forward)
+char checkpointPath[512] = "";
+unsigned int checkpointEvery = 100;
+char restorePath[512] = "";
+unsigned int fastForwardFrame = 0;
+// Force evaluations of all satellites per physics call, over all frames
+long long forceEvaluationsSum = 0, forceEvaluationsMin = 0, forceEvaluationsMax = 0;
+unsigned int forceEvaluationFrames = 0;
+
+// Allowed satellite position error of the selected physics, a higher
+// order integrator or fewer substeps cannot match the reference bit by bit
+static double physicsTolerance(void){
+   double tolerance = physicsEngine->tolerance;
+   if ((integrator != INTEGRATOR_EULER || adaptiveEta > 0.0 ||
+        physicsUpdatesPerFrame != referenceUpdatesPerFrame) &&
+       tolerance < INTEGRATOR_TOLERANCE) {
+      tolerance = INTEGRATOR_TOLERANCE;
+   }
+#ifdef HAVE_OPENCL
+   if (physicsEngine == &openclPhysics && tolerance < openclPhysicsTolerance()) {
+      tolerance = openclPhysicsTolerance();
+   }
+#endif
+   return tolerance;
+}
+
+// Checks against the reference, after init(): the tolerance is known once
+// the engines have picked their kernels (--cl-precision)
+static void validationInit(void){
+   validationReport.satelliteTolerance = physicsTolerance();
+   samplerInit(sampleEvery, samplePixels, seed, physicsTolerance());
+}
+
+// Sequential reference color of pixel (x, y) with the black hole at
+// (mouseX, mouseY). Used for finding errors
+color_u8 sequentialPixel(const satellite *sats, int count, int mouseX, int mouseY, int x, int y){
+      color_u8 result = {.red = 0, .green = 0, .blue = 0, .reserved = 0};
+
+      floatvector pixel = {.x = x, .y = y};
+
+      // Draw the black hole
+      floatvector positionToBlackHole = {.x = pixel.x -
+         mouseX, .y = pixel.y - mouseY};
+      float distToBlackHoleSquared =
+         positionToBlackHole.x * positionToBlackHole.x +
+         positionToBlackHole.y * positionToBlackHole.y;
+      float distToBlackHole = sqrt(distToBlackHoleSquared);
+      if (distToBlackHole < BLACK_HOLE_RADIUS) {
+         return result; // Black hole drawing done
+      }
+
+      // This color is used for coloring the pixel
+      color_f32 renderColor = {.red = 0.f, .green = 0.f, .blue = 0.f};
+
+      // Find closest satellite
+      float shortestDistance = INFINITY;
+
+      float weights = 0.f;
+      int hitsSatellite = 0;
+
+      // First Graphics satellite loop: Find the closest satellite.
+      for(int j = 0; j < count; ++j){
+         floatvector difference = {.x = pixel.x - sats[j].position.x,
+                                   .y = pixel.y - sats[j].position.y};
+         float distance = sqrt(difference.x * difference.x +
+                               difference.y * difference.y);
+
+         if(distance < SATELLITE_RADIUS) {
+            renderColor.red = 1.0f;
+            renderColor.green = 1.0f;
+            renderColor.blue = 1.0f;
+            hitsSatellite = 1;
+            break;
+         } else {
+            float weight = 1.0f / (distance*distance*distance*distance);
+            weights += weight;
+            if(distance < shortestDistance){
+               shortestDistance = distance;
+               renderColor = sats[j].identifier;
+            }
+         }
+      }
+
+      // Second graphics loop: Calculate the color based on distance to every satellite.
+      if (!hitsSatellite) {
+         for(int j = 0; j < count; ++j){
+            floatvector difference = {.x = pixel.x - sats[j].position.x,
+                                      .y = pixel.y - sats[j].position.y};
+            float dist2 = (difference.x * difference.x +
+                           difference.y * difference.y);
+            float weight = 1.0f/(dist2* dist2);
+
+            renderColor.red += (sats[j].identifier.red *
+                                weight /weights) * 3.0f;
+
+            renderColor.green += (sats[j].identifier.green *
+                                  weight / weights) * 3.0f;
+
+            renderColor.blue += (sats[j].identifier.blue *
+                                 weight / weights) * 3.0f;
+         }
+      }
+      result.red = (uint8_t) (renderColor.red * 255.0f);
+      result.green = (uint8_t) (renderColor.green * 255.0f);
+      result.blue = (uint8_t) (renderColor.blue * 255.0f);
+      return result;
+}
+
+// Sequential rendering loop used for finding errors
+void sequentialGraphicsEngine(){
+    // Graphics pixel loop, row wise ordering
+    for(int i = 0 ;i < SIZE; ++i) {
+      correctPixels[i] = sequentialPixel(satellites, satelliteCount,
+                                         HORIZONTAL_CENTER, VERTICAL_CENTER,
+                                         i % windowWidth, i / windowWidth);
+    }
+}
+
+// Sequential reference physics of count satellites with the black hole
+// at (mouseX, mouseY), always Euler with referenceUpdatesPerFrame substeps
+void sequentialPhysicsEngine(satellite *s, int count, int mouseX, int mouseY){
+
+   // double precision required for accumulation inside this routine,
+   // but float storage is ok outside these loops.
+   doublevector *tmpPosition = (doublevector*)malloc(sizeof(doublevector) * count);
+   doublevector *tmpVelocity = (doublevector*)malloc(sizeof(doublevector) * count);
+
+   for (int i = 0; i < count; ++i) {
+       tmpPosition[i].x = s[i].position.x;
+       tmpPosition[i].y = s[i].position.y;
+       tmpVelocity[i].x = s[i].velocity.x;
+       tmpVelocity[i].y = s[i].velocity.y;
+   }
+
+   // Physics iteration loop
+   for(int physicsUpdateIndex = 0;
+       physicsUpdateIndex < referenceUpdatesPerFrame;
+      ++physicsUpdateIndex){
+
+       // Physics satellite loop
+      for(int i = 0; i < count; ++i){
+
+         // Distance to the blackhole
+         // (bit ugly code because C-struct cannot have member functions)
+         doublevector positionToBlackHole = {.x = tmpPosition[i].x -
+            mouseX, .y = tmpPosition[i].y - mouseY};
+         double distToBlackHoleSquared =
+            positionToBlackHole.x * positionToBlackHole.x +
+            positionToBlackHole.y * positionToBlackHole.y;
+         double distToBlackHole = sqrt(distToBlackHoleSquared);
+
+         // Gravity force
+         doublevector normalizedDirection = {
+            .x = positionToBlackHole.x / distToBlackHole,
+            .y = positionToBlackHole.y / distToBlackHole};
+         double accumulation = GRAVITY / distToBlackHoleSquared;
+
+         // Delta time is used to make velocity same despite different FPS
+         // Update velocity based on force
+         tmpVelocity[i].x -= accumulation * normalizedDirection.x *
+            DELTATIME / referenceUpdatesPerFrame;
+         tmpVelocity[i].y -= accumulation * normalizedDirection.y *
+            DELTATIME / referenceUpdatesPerFrame;
+
+         // Update position based on velocity
+         tmpPosition[i].x +=
+            tmpVelocity[i].x * DELTATIME / referenceUpdatesPerFrame;
+         tmpPosition[i].y +=
+            tmpVelocity[i].y * DELTATIME / referenceUpdatesPerFrame;
+      }
+   }
+
+   // double precision required for accumulation inside this routine,
+   // but float storage is ok outside these loops.
+   // copy back the float storage.
+   for (int i = 0; i < count; ++i) {
+       s[i].position.x = tmpPosition[i].x;
+       s[i].position.y = tmpPosition[i].y;
+       s[i].velocity.x = tmpVelocity[i].x;
+       s[i].velocity.y = tmpVelocity[i].y;
+   }
+   free(tmpPosition);
+   free(tmpVelocity);
+}
+
+// Compares the engine output to the sequential reference, failures are
+// collected to validationReport instead of stopping the program
+void errorCheck(){
+   validationComparePixels(&validationReport, correctPixels, pixels, SIZE,
+                           windowWidth, frameNumber);
+}
+
+
+// Black hole position of a frame after the checked ones
+static void blackHolePosition(unsigned int frame, int *x, int *y){
+   if (trajectoryPosition(frame, x, y)) {
+      // Black hole position comes from the --replay file
+   } else if (!headlessFrames) {
+      SDL_GetMouseState(x, y);
+      if ((*x == 0) && (*y == 0)) {
+         *x = HORIZONTAL_CENTER;
+         *y = VERTICAL_CENTER;
+      }
+   }
+}
+
+// Checks once the window exists whether the engines can draw into its
+// surface: 32 bit blue, green, red, x pixels like color_u8, and no lock
+static void surfaceInit(void){
+   surfaceDirect = 0;
+   if (!zeroCopy || !surf) {
+      return;
+   }
+   const char *reason = NULL;
+   if (pipelineDepth > 1) {
+      reason = "the pipeline draws while the window shows the previous frame";
+   } else if (SDL_MUSTLOCK(surf)) {
+      reason = "the surface must be locked";
+   } else if ((surf->format->format != SDL_PIXELFORMAT_RGB888 &&
+               surf->format->format != SDL_PIXELFORMAT_ARGB8888) ||
+              SDL_BYTEORDER != SDL_LIL_ENDIAN || surf->pitch % sizeof(color_u8)) {
+      reason = SDL_GetPixelFormatName(surf->format->format);
+   } else if (surf->w != windowWidth || surf->h != windowHeight) {
+      reason = "the surface has another size";
+   }
+   if (reason) {
+      printf("Copying frames to the window surface: %s\n", reason);
+      return;
+   }
+   surfaceDirect = 1;
+   printf("Drawing straight into the window surface, %d bytes per row\n", surf->pitch);
+}
+
+// Target of the graphics of frame frameNumber
+static void selectFrameTarget(void){
+   if (surfaceDirect && frameNumber >= 2) {
+      frameTarget = (color_u8*)surf->pixels;
+      frameStride = surf->pitch / (int)sizeof(color_u8);
+   } else {
+      frameTarget = pixels;
+      frameStride = windowWidth;
+   }
+}
+
+// Adds frameForceEvaluations of the last physics call to the statistics
+static void recordForceEvaluations(void){
+   if (forceEvaluationFrames == 0 || frameForceEvaluations < forceEvaluationsMin) {
+      forceEvaluationsMin = frameForceEvaluations;
+   }
+   if (frameForceEvaluations > forceEvaluationsMax) {
+      forceEvaluationsMax = frameForceEvaluations;
+   }
+   forceEvaluationsSum += frameForceEvaluations;
+   forceEvaluationFrames++;
+}
+
+void compute(void){
+   uint64_t computeStart = timingNow();
+   // Time spent on the sequential reference code and the checks
+   uint64_t validationTime = 0;
+
+   if (frameNumber == 0) {
+      firstFrameTime = timingNow();
+   }
+
+   // Error check during first frames
+   if (frameNumber < 2) {
+      uint64_t validationStart = timingNow();
+      memcpy(backupSatelites, satellites, sizeof(satellite) * satelliteCount);
+      sequentialPhysicsEngine(backupSatelites, satelliteCount,
+                              HORIZONTAL_CENTER, VERTICAL_CENTER);
+      traceSpan("reference physics", "validation", TRACE_TID_MAIN,
+                validationStart, timingNow(), "frame", frameNumber);
+      validationTime += timingNow() - validationStart;
+      mousePosX = HORIZONTAL_CENTER;
+      mousePosY = VERTICAL_CENTER;
+   } else {
+      blackHolePosition(frameNumber, &mousePosX, &mousePosY);
+   }
+   trajectoryRecord(frameNumber, (timingNow() - firstFrameTime) / 1e6, mousePosX, mousePosY);
+
+   samplerBeforePhysics(frameNumber, satellites, satelliteCount);
+
+   uint64_t satelliteMovementStart = timingNow();
+   // With --speculate the physics may already be done
+   if (!speculateCommit(satellites, satelliteCount, mousePosX, mousePosY)) {
+      frameForceEvaluations = 0;
+      parallelPhysicsEngine();
+   }
+   uint64_t satelliteMovementTime = timingNow() - satelliteMovementStart;
+   traceSpan("physics", "stage", TRACE_TID_MAIN, satelliteMovementStart,
+             satelliteMovementStart + satelliteMovementTime, "frame", frameNumber);
+
+   samplerAfterPhysics(frameNumber, satellites, satelliteCount);
+
+   recordForceEvaluations();
+
+   if (frameNumber < 2) {
+      uint64_t validationStart = timingNow();
+      validationCompareSatellites(&validationReport, backupSatelites, satellites,
+                                  satelliteCount, frameNumber);
+      traceSpan("check satellites", "validation", TRACE_TID_MAIN,
+                validationStart, timingNow(), "frame", frameNumber);
+      validationTime += timingNow() - validationStart;
+   }
+
+   // The next frame moves the satellites on the spare threads while this
+   // one renders, unless it is the last one. The black hole is assumed to
+   // stay, a --replay file tells where it goes.
+   if (!headlessFrames || frameNumber + 1 < headlessFrames) {
+      int nextX = mousePosX, nextY = mousePosY;
+      if (frameNumber + 1 >= 2) {
+         trajectoryPosition(frameNumber + 1, &nextX, &nextY);
+      }
+      speculateStart(satellites, satelliteCount, nextX, nextY);
+   }
+
+   // Decides the colors for the pixels, the checked frames into pixels
+   selectFrameTarget();
+   uint64_t pixelColoringStart = timingNow();
+   parallelGraphicsEngine();
+   uint64_t pixelColoringTime = timingNow() - pixelColoringStart;
+   traceSpan("graphics", "stage", TRACE_TID_MAIN, pixelColoringStart,
+             pixelColoringStart + pixelColoringTime, "frame", frameNumber);
+
+   samplerAfterGraphics(frameNumber, frameTarget, windowWidth, windowHeight, frameStride,
+                        mousePosX, mousePosY);
+
+   uint64_t finishTime = timingNow();
+   // Sequential code is used to check possible errors in the parallel version
+   if(frameNumber < 2){
+      uint64_t validationStart = timingNow();
+      sequentialGraphicsEngine();
+      errorCheck();
+      traceSpan("reference graphics", "validation", TRACE_TID_MAIN,
+                validationStart, timingNow(), "frame", frameNumber);
+      validationTime += timingNow() - validationStart;
+      timingRecord(&validationTiming, validationTime);
+   } else if (frameNumber == 2 || !previousFinishTime) {
+      // Also the first frame after --restore or --fast-forward
+      previousFinishTime = finishTime;
+      printf("Time spent on moving satellites + Time spent on space coloring : Total time in milliseconds between frames (might not equal the sum of the left-hand expression)\n");
+   } else if (frameNumber > 2) {
+     // Print timings
+     uint64_t totalTime = finishTime - previousFinishTime;
+     previousFinishTime = finishTime;
+
+     printf("Latency of this frame %.3f + %.3f : %.3fms \n",
+             satelliteMovementTime / 1e6, pixelColoringTime / 1e6, totalTime / 1e6);
+
+     timingRecord(&physicsTiming, satelliteMovementTime);
+     timingRecord(&graphicsTiming, pixelColoringTime);
+     timingRecord(&frameTiming, totalTime);
+     printf("Averaged over all frames: %.3f + %.3f : %.3fms.\n",
+             timingMean(&physicsTiming) / 1e6, timingMean(&graphicsTiming) / 1e6,
+             timingMean(&frameTiming) / 1e6);
+
+   }
+   traceSpan("compute", "frame", TRACE_TID_MAIN, computeStart, timingNow(),
+             "frame", frameNumber);
+}
+
+// Prints the latency distribution of every stage
+void printTimingReport(void){
+   printf("Stage latencies over %llu frames:\n", (unsigned long long)frameTiming.count);
+   timingPrint("physics", &physicsTiming);
+   timingPrint("graphics", &graphicsTiming);
+   timingPrint("present", &presentTiming);
+   timingPrint("validation", &validationTiming);
+   timingPrint("frame", &frameTiming);
+   if (physicsEngine == &pararealPhysics) {
+      pararealPrint();
+   }
+   speculatePrint();
+   if (forceEvaluationsSum > 0) {
+      printf("Force evaluations per frame: mean %.0f  min %lld  max %lld\n",
+             (double)forceEvaluationsSum / forceEvaluationFrames,
+             forceEvaluationsMin, forceEvaluationsMax);
+   }
+#ifdef HAVE_OPENCL
+   openclPrintProfile();
+#endif
+}
+
+// Probably not the best random number generator
+float randomNumber(float min, float max){
+   return (rand() * (max - min) / RAND_MAX) + min;
+}
+
+// Creates count random satellites around the window center with rand(),
+// the caller seeds it
+void createSatellites(satellite *sats, int count){
+   for(int i = 0; i < count; ++i){
+
+      // Random reddish color
+      color_f32 id = {.red = randomNumber(0.f, 0.15f) + 0.1f,
+                  .green = randomNumber(0.f, 0.14f) + 0.0f,
+                  .blue = randomNumber(0.f, 0.16f) + 0.0f};
+
+      // Random position with margins to borders
+      floatvector initialPosition = {.x = HORIZONTAL_CENTER - randomNumber(50, 320),
+                              .y = VERTICAL_CENTER - randomNumber(50, 320) };
+      initialPosition.x = (i / 2 % 2 == 0) ?
+         initialPosition.x : windowWidth - initialPosition.x;
+      initialPosition.y = (i < count / 2) ?
+         initialPosition.y : windowHeight - initialPosition.y;
+
+      // Randomize velocity tangential to the balck hole
+      floatvector positionToBlackHole = {.x = initialPosition.x - HORIZONTAL_CENTER,
+                                    .y = initialPosition.y - VERTICAL_CENTER};
+      float distance = (0.06 + randomNumber(-0.01f, 0.01f))/
+        sqrt(positionToBlackHole.x * positionToBlackHole.x +
+          positionToBlackHole.y * positionToBlackHole.y);
+      floatvector initialVelocity = {.x = distance * -positionToBlackHole.y,
+                                .y = distance * positionToBlackHole.x};
+
+      // Every other orbits clockwise
+      if(i % 2 == 0){
+         initialVelocity.x = -initialVelocity.x;
+         initialVelocity.y = -initialVelocity.y;
+      }
+
+      satellite tmpSatelite = {.identifier = id, .position = initialPosition,
+                              .velocity = initialVelocity};
+      sats[i] = tmpSatelite;
+   }
+}
+
+void fixedInit(unsigned int seed){
+
+   if(seed != 0){
+     srand(seed);
+   }
+
+   validationReset(&validationReport);
+
+   // Init pixel buffer which is rendered to the widow
+   pixels = (color_u8*)alignedAlloc(sizeof(color_u8) * SIZE);
+
+   // Init pixel buffer which is used for error checking
+   correctPixels = (color_u8*)alignedAlloc(sizeof(color_u8) * SIZE);
+
+   backupSatelites = (satellite*)alignedAlloc(sizeof(satellite) * satelliteCount);
+
+
+   // Init satellites buffer which are moving in the space
+   satellites = (satellite*)alignedAlloc(sizeof(satellite) * satelliteCount);
+
+   if (!pixels || !correctPixels || !backupSatelites || !satellites) {
+      printf("Out of memory for %d satellites at %dx%d\n",
+             satelliteCount, windowWidth, windowHeight);
+      exit(-1);
+   }
+
+   // Create random satellites
+   createSatellites(satellites, satelliteCount);
+}
+
+static void pipelineDestroy(void);
+static void saveCheckpoint(int wait);
+
+void fixedDestroy(void){
+   // The final state, then the writer thread stops
+   saveCheckpoint(1);
+   checkpointDestroy();
+   checkpointPrint();
+   // The speculation and pipeline threads run the engines
+   speculateDestroy();
+   pipelineDestroy();
+   destroy();
+   samplerDestroy();
+   trajectoryClose();
+   traceClose();
+
+   alignedFree(pixels);
+   alignedFree(correctPixels);
+   alignedFree(satellites);
+   alignedFree(backupSatelites);
+
+   if(seed != 0){
+     printf("Used seed: %i\n", seed);
+   }
+}
+
+// Copies a pixel buffer of frame to the window, nothing without one
+static void present(const color_u8 *frame, unsigned int number){
+   if (!win) {
+      return;
+   }
+   uint64_t presentStart = timingNow();
+   // Nothing to copy when the engine drew into the surface
+   if (frame != surf->pixels) {
+      SDL_LockSurface(surf);
+      if (surf->pitch == (int)sizeof(color_u8) * windowWidth) {
+         memcpy(surf->pixels, frame, sizeof(color_u8) * SIZE);
+      } else {
+         for (int y = 0; y < windowHeight; ++y) {
+            memcpy((char*)surf->pixels + (size_t)y * surf->pitch, frame + (size_t)y * windowWidth,
+                   sizeof(color_u8) * windowWidth);
+         }
+      }
+      SDL_UnlockSurface(surf);
+   }
+   uint64_t copyEnd = timingNow();
+   traceSpan("surface copy", "present", TRACE_TID_MAIN, presentStart, copyEnd,
+             "frame", number);
+
+   SDL_UpdateWindowSurface(win);
+   traceSpan("update window", "present", TRACE_TID_MAIN, copyEnd, timingNow(),
+             "frame", number);
+   if (number > 2) {
+      timingRecord(&presentTiming, timingNow() - presentStart);
+   }
+}
+
+// Renders the frame to the window, pixels unless it was drawn in place
+void render(void){
+   present(frameTarget, frameNumber);
+   frameNumber++;
+}
+
+////////////////////////////////////////////////
+// ¤¤ Pipelined frame loop (--pipeline) ¤¤    //
+////////////////////////////////////////////////
+
+// One run of a stage on its worker
+typedef struct {
+   unsigned int frame;
+   const satellite *sats;   // graphics only, physics moves satellites
+   color_u8 *out;           // graphics only
+   int mouseX;
+   int mouseY;
+   uint64_t time;
+} StageJob;
+
+static PipelineWorker *physicsWorker = NULL;
+static PipelineWorker *graphicsWorker = NULL;
+static StageJob physicsJob, graphicsJob;
+// Copy of the satellites of the frame being drawn while the physics
+// moves them to the next frame
+static satellite *renderSatellites = NULL;
+// Frame f is drawn into pixelBuffers[f % 2], the first one is pixels
+static color_u8 *pixelBuffers[2] = {NULL, NULL};
+// The frame that has moved but is not drawn yet, and the one that is
+// drawn but not shown yet (depth 3), -1 when there is none
+static long long pendingGraphics = -1, pendingPresent = -1;
+
+static void physicsStage(void *data){
+   StageJob *job = (StageJob*)data;
+   traceSetOpenmpRows(TRACE_TID_OPENMP_PHYSICS_WORKER);
+   uint64_t start = timingNow();
+   frameForceEvaluations = 0;
+   physicsEngine->run(satellites, satelliteCount, job->mouseX, job->mouseY);
+   job->time = timingNow() - start;
+   traceSpan("physics", "stage", TRACE_TID_PHYSICS_WORKER, start, start + job->time,
+             "frame", job->frame);
+}
+
+static void graphicsStage(void *data){
+   StageJob *job = (StageJob*)data;
+   traceSetOpenmpRows(TRACE_TID_OPENMP_GRAPHICS_WORKER);
+   uint64_t start = timingNow();
+   graphicsEngine->run(job->sats, satelliteCount, job->mouseX, job->mouseY, job->out,
+                       windowWidth);
+   job->time = timingNow() - start;
+   traceSpan("graphics", "stage", TRACE_TID_GRAPHICS_WORKER, start, start + job->time,
+             "frame", job->frame);
+}
+
+// Starts the workers when --pipeline is 2 or more, after init()
+static void pipelineInit(void){
+   if (pipelineDepth < 2) {
+      return;
+   }
+   renderSatellites = (satellite*)alignedAlloc(sizeof(satellite) * satelliteCount);
+   pixelBuffers[0] = pixels;
+   pixelBuffers[1] = (color_u8*)alignedAlloc(sizeof(color_u8) * SIZE);
+   if (!renderSatellites || !pixelBuffers[1]) {
+      printf("Out of memory for the pipeline buffers\n");
+      exit(-1);
+   }
+   physicsWorker = pipelineWorkerStart("physics", physicsStage, &physicsJob);
+   graphicsWorker = pipelineWorkerStart("graphics", graphicsStage, &graphicsJob);
+   printf("Pipelined frame loop of depth %d: physics of frame N+1 with graphics of frame N%s\n",
+          pipelineDepth, pipelineDepth >= 3 ? " and presentation of frame N-1" : "");
+}
+
+// One step of the pipelined loop, in place of compute() and render()
+// after the checked frames. Moves frame frameNumber while the previous
+// frame is drawn, and at depth 3 the one before it is shown meanwhile.
+static void pipelineFrame(void){
+   uint64_t tickStart = timingNow();
+   unsigned int frame = frameNumber;
+   blackHolePosition(frame, &mousePosX, &mousePosY);
+   trajectoryRecord(frame, (tickStart - firstFrameTime) / 1e6, mousePosX, mousePosY);
+
+   // The graphics get their own copy of the satellites they draw
+   long long drawFrame = pendingGraphics;
+   if (drawFrame >= 0) {
+      memcpy(renderSatellites, satellites, sizeof(satellite) * satelliteCount);
+      graphicsJob.frame = (unsigned int)drawFrame;
+      graphicsJob.sats = renderSatellites;
+      graphicsJob.out = pixelBuffers[drawFrame % 2];
+      graphicsJob.mouseX = physicsJob.mouseX;
+      graphicsJob.mouseY = physicsJob.mouseY;
+      graphicsJob.time = 0;
+      pipelineWorkerKick(graphicsWorker);
+   }
+
+   samplerBeforePhysics(frame, satellites, satelliteCount);
+   physicsJob.frame = frame;
+   physicsJob.mouseX = mousePosX;
+   physicsJob.mouseY = mousePosY;
+   pipelineWorkerKick(physicsWorker);
+
+   long long showFrame = pipelineDepth >= 3 ? pendingPresent : -1;
+   if (showFrame >= 0) {
+      present(pixelBuffers[showFrame % 2], (unsigned int)showFrame);
+   }
+
+   pipelineWorkerWait(physicsWorker);
+   pipelineWorkerWait(graphicsWorker);
+   samplerAfterPhysics(frame, satellites, satelliteCount);
+   recordForceEvaluations();
+   if (drawFrame >= 0) {
+      samplerAfterGraphics(graphicsJob.frame, graphicsJob.out, windowWidth, windowHeight, windowWidth,
+                           graphicsJob.mouseX, graphicsJob.mouseY);
+   }
+   if (drawFrame >= 0 && pipelineDepth < 3) {
+      present(graphicsJob.out, graphicsJob.frame);
+      drawFrame = -1;
+   }
+   pendingPresent = drawFrame;
+   pendingGraphics = frame;
+
+   uint64_t finishTime = timingNow();
+   if (frame == 2 || !previousFinishTime) {
+      previousFinishTime = finishTime;
+      printf("Time spent on moving satellites | Time spent on space coloring of the previous frame : Total time in milliseconds between frames\n");
+   } else {
+      uint64_t totalTime = finishTime - previousFinishTime;
+      previousFinishTime = finishTime;
+      printf("Latency of this pipelined frame %.3f | %.3f : %.3fms \n",
+             physicsJob.time / 1e6, graphicsJob.time / 1e6, totalTime / 1e6);
+      timingRecord(&physicsTiming, physicsJob.time);
+      if (graphicsJob.time) {
+         timingRecord(&graphicsTiming, graphicsJob.time);
+      }
+      timingRecord(&frameTiming, totalTime);
+   }
+   traceSpan("pipeline step", "frame", TRACE_TID_MAIN, tickStart, timingNow(),
+             "frame", frame);
+}
+
+// Draws and shows the frames still in the pipeline, without overlap
+static void pipelineFlush(void){
+   if (pendingPresent >= 0) {
+      present(pixelBuffers[pendingPresent % 2], (unsigned int)pendingPresent);
+      pendingPresent = -1;
+   }
+   if (pendingGraphics >= 0) {
+      color_u8 *out = pixelBuffers[pendingGraphics % 2];
+      graphicsEngine->run(satellites, satelliteCount, physicsJob.mouseX, physicsJob.mouseY, out,
+                          windowWidth);
+      samplerAfterGraphics((unsigned int)pendingGraphics, out, windowWidth, windowHeight, windowWidth,
+                           physicsJob.mouseX, physicsJob.mouseY);
+      present(out, (unsigned int)pendingGraphics);
+      pendingGraphics = -1;
+   }
+}
+
+static void pipelineDestroy(void){
+   pipelineWorkerStop(physicsWorker);
+   pipelineWorkerStop(graphicsWorker);
+   physicsWorker = graphicsWorker = NULL;
+   alignedFree(renderSatellites);
+   alignedFree(pixelBuffers[1]);
+   renderSatellites = NULL;
+   pixelBuffers[0] = pixelBuffers[1] = NULL;
+}
+
+////////////////////////////////////////////////
+// ¤¤ Checkpoints and fast-forward ¤¤         //
+////////////////////////////////////////////////
+
+// Frame of the last checkpoint handed to the writer, -1 before the first
+static long long savedFrame = -1;
+
+// Checkpoints the state before frame frameNumber, when --checkpoint is set
+static void saveCheckpoint(int wait){
+   if (!checkpointPath[0] || savedFrame == frameNumber) {
+      return;
+   }
+   CheckpointHeader header;
+   memset(&header, 0, sizeof(header));
+   header.satelliteCount = satelliteCount;
+   header.frame = frameNumber;
+   header.mouseX = mousePosX;
+   header.mouseY = mousePosY;
+   header.width = windowWidth;
+   header.height = windowHeight;
+   header.substeps = physicsUpdatesPerFrame;
+   header.integrator = integrator;
+   header.seed = seed;
+   header.samplerRandom = samplerRandomState();
+   if (checkpointSave(&header, satellites, wait)) {
+      savedFrame = frameNumber;
+   }
+}
+
+// Reads --restore before fixedInit(), the checkpoint decides the sizes
+static CheckpointHeader restoreHeader;
+static satellite *restoreSatellites = NULL;
+
+static int loadRestore(void){
+   if (checkpointLoad(restorePath, &restoreHeader, &restoreSatellites)) {
+      return -1;
+   }
+   satelliteCount = restoreHeader.satelliteCount;
+   windowWidth = restoreHeader.width;
+   windowHeight = restoreHeader.height;
+   if (!seed) {
+      seed = restoreHeader.seed;
+   }
+   if (restoreHeader.substeps != physicsUpdatesPerFrame ||
+       restoreHeader.integrator != integrator) {
+      printf("Warning: the checkpoint was made with %d %s substeps per frame\n",
+             restoreHeader.substeps, integratorName(restoreHeader.integrator));
+   }
+   return 0;
+}
+
+// Replaces the new satellites of fixedInit() by the restored ones, the
+// run goes on at the checkpointed frame
+static void applyRestore(void){
+   memcpy(satellites, restoreSatellites, sizeof(satellite) * satelliteCount);
+   alignedFree(restoreSatellites);
+   restoreSatellites = NULL;
+   frameNumber = restoreHeader.frame;
+   mousePosX = restoreHeader.mouseX;
+   mousePosY = restoreHeader.mouseY;
+   firstFrameTime = timingNow();
+   // Not saved again unless it moves on
+   savedFrame = frameNumber;
+   printf("Restored %d satellites at %dx%d from %s, resuming at frame %u\n",
+          satelliteCount, windowWidth, windowHeight, restorePath, frameNumber);
+}
+
+// Runs the physics up to frame target without drawing. The two checked
+// frames run in full, the black hole then goes where the frame loop
+// would put it.
+static void fastForward(unsigned int target){
+   unsigned int startFrame = frameNumber;
+   uint64_t startTime = timingNow();
+   while (frameNumber < target) {
+      if (frameNumber < 2) {
+         compute();
+         frameNumber++;
+         continue;
+      }
+      blackHolePosition(frameNumber, &mousePosX, &mousePosY);
+      trajectoryRecord(frameNumber, (timingNow() - firstFrameTime) / 1e6, mousePosX, mousePosY);
+      uint64_t physicsStart = timingNow();
+      if (!speculateCommit(satellites, satelliteCount, mousePosX, mousePosY)) {
+         frameForceEvaluations = 0;
+         parallelPhysicsEngine();
+      }
+      traceSpan("fast-forward physics", "stage", TRACE_TID_MAIN, physicsStart, timingNow(),
+                "frame", frameNumber);
+      recordForceEvaluations();
+      frameNumber++;
+      if (checkpointDue(frameNumber)) {
+         saveCheckpoint(0);
+      }
+   }
+   uint64_t time = timingNow() - startTime;
+   if (frameNumber > startFrame) {
+      printf("Fast-forward from frame %u to %u in %.3f ms, %.1f frames/s\n",
+             startFrame, frameNumber, time / 1e6,
+             time ? (frameNumber - startFrame) / (time / 1e9) : 0.0);
+   }
+}
+
+// One frame of the loop, serial or pipelined
+static void runFrame(void){
+   if (physicsWorker && frameNumber >= 2) {
+      pipelineFrame();
+      frameNumber++;
+   } else if (headlessFrames) {
+      compute();
+      frameNumber++;
+   } else {
+      compute();
+      render();
+   }
+   if (checkpointDue(frameNumber)) {
+      saveCheckpoint(0);
+   }
+}
+
+// Prints the correctness report and writes it to --report.
+// Returns the exit code of the program, 2 when the validation failed or
+// the sampled checks raised a drift alarm.
+int finishValidation(void){
+   samplerDestroy();
+   validationPrint("Correctness", &validationReport);
+   samplerPrint(frameTiming.sum);
+   if (reportPath[0]) {
+      FILE *f = fopen(reportPath, "w");
+      if (f) {
+         validationPrintJson(f, &validationReport);
+         fprintf(f, "\n");
+         fclose(f);
+      } else {
+         printf("Cannot write report: %s\n", reportPath);
+      }
+   }
+   return validationPassed(&validationReport) && samplerPassed() ? 0 : 2;
+}
+
+// Inits the engines and checks after fixedInit(), then resumes a
+// --restore checkpoint and runs the --fast-forward frames
+static void startRun(void){
+   if (restorePath[0]) {
+      applyRestore();
+   }
+   init();
+   validationInit();
+   if (restorePath[0]) {
+      samplerSetRandomState(restoreHeader.samplerRandom);
+   }
+   if (checkpointPath[0]) {
+      checkpointInit(checkpointPath, checkpointEvery);
+   }
+   fastForward(fastForwardFrame);
+   pipelineInit();
+}
+
+// Runs headlessFrames frames without a window and prints a timing summary.
+// The black hole stays in the center unless --replay moves it, so runs
+// are comparable. Returns the exit code of finishValidation().
+int runHeadless(void){
+   uint64_t startTime = timingNow();
+   while (frameNumber < headlessFrames) {
+      runFrame();
+   }
+   pipelineFlush();
+   uint64_t wallTime = timingNow() - startTime;
+
+   printTimingReport();
+   int exitCode = finishValidation();
+
+   // One JSON line, the timed frames are the ones after the error check frames
+   printf("{\"physics\":\"%s\",\"graphics\":\"%s\",\"satellites\":%d,\"width\":%d,\"height\":%d,\"substeps\":%d,"
+          "\"integrator\":\"%s\",\"pipeline\":%d,\"frames\":%u,\"timed_frames\":%llu,\"wall_ms\":%.3f,"
+          "\"physics_ms_avg\":%.3f,\"graphics_ms_avg\":%.3f,\"frame_ms_avg\":%.3f,\"stages\":{",
+          physicsEngine->name, graphicsEngine->name,
+          satelliteCount, windowWidth, windowHeight, physicsUpdatesPerFrame,
+          integratorName(integrator), pipelineDepth, headlessFrames,
+          (unsigned long long)frameTiming.count, wallTime / 1e6,
+          timingMean(&physicsTiming) / 1e6,
+          timingMean(&graphicsTiming) / 1e6,
+          timingMean(&frameTiming) / 1e6);
+   timingPrintJson(stdout, "physics", &physicsTiming);
+   printf(",");
+   timingPrintJson(stdout, "graphics", &graphicsTiming);
+   printf(",");
+   timingPrintJson(stdout, "validation", &validationTiming);
+   printf(",");
+   timingPrintJson(stdout, "frame", &frameTiming);
+   printf("},\"adaptive_eta\":%g,\"force_evaluations\":{\"mean\":%.0f,\"min\":%lld,\"max\":%lld}",
+          adaptiveEta,
+          forceEvaluationFrames ? (double)forceEvaluationsSum / forceEvaluationFrames : 0.0,
+          forceEvaluationsMin, forceEvaluationsMax);
+   if (physicsEngine == &pararealPhysics) {
+      printf(",\"parareal\":");
+      pararealPrintJson(stdout);
+   }
+   if (speculateThreads) {
+      printf(",\"speculation\":");
+      speculatePrintJson(stdout);
+   }
+   printf(",\"accuracy\":");
+   validationPrintJson(stdout, &validationReport);
+   printf(",\"sampling\":");
+   samplerPrintJson(stdout);
+#ifdef HAVE_OPENCL
+   if (clProfiling) {
+      printf(",\"opencl\":");
+      openclPrintProfileJson(stdout);
+   }
+#endif
+   printf("}\n");
+   return exitCode;
+}
+
+// Integer option value in [min, max]. Returns 0 on success, or -1 after
+// printing an error when the value is not a whole number in the range.
+static int integerValue(const char *name, const char *value, long long min, long long max,
+                        long long *number){
+   char *end;
+   long long parsed = strtoll(value, &end, 10);
+   if (end == value || *end != '\0' || parsed < min || parsed > max) {
+      printf("Invalid %s: %s\n", name, value);
+      return -1;
+   }
+   *number = parsed;
+   return 0;
+}
+
+// Count option value of at least min (0 or 1), -1 after an error message
+// when it is not one
+static int countValue(const char *name, const char *value, int min){
+   long long number;
+   return integerValue(name, value, min, 1000000000LL, &number) ? -1 : (int)number;
+}
+
+// Finite floating point option value of at least min. Returns 0 on
+// success, or -1 after printing an error.
+static int realValue(const char *name, const char *value, double min, double *number){
+   char *end;
+   double parsed = strtod(value, &end);
+   if (end == value || *end != '\0' || !isfinite(parsed) || !(parsed >= min)) {
+      printf("Invalid %s: %s\n", name, value);
+      return -1;
+   }
+   *number = parsed;
+   return 0;
+}
+
+static int readConfig(const char *path);
+
+// Options that are followed by a value on the command line
+static const char *valueOptions[] = {
+   "seed", "headless", "physics", "graphics", "local",
+   "satellites", "width", "height", "substeps", "config",
+   "record", "replay", "report", "sample-every", "sample-pixels",
+   "cl-profile", "trace", "integrator", "reference-substeps", "calibrate",
+   "adaptive", "simd", "slices", "parareal-tolerance", "parareal-coarse", "cl-precision",
+   "speculate", "pipeline", "ensemble", "ensemble-output", "checkpoint",
+   "checkpoint-every", "restore", "fast-forward", "tile",
+   "incremental", "zero-copy", NULL
+};
+
+static int takesValue(const char *name){
+   for (int i = 0; valueOptions[i]; ++i) {
+      if (!strcmp(valueOptions[i], name)) {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+// Applies one option, given as "--name value" on the command line or as
+// "name = value" in a config file. Returns 0 on success.
+static int applyOption(const char *name, const char *value){
+   if (!strcmp(name, "seed")) {
+      // Negative seeds wrap around like before
+      long long number;
+      if (integerValue(name, value, -2147483648LL, 4294967295LL, &number)) {
+         return -1;
+      }
+      seed = (unsigned int)number;
+      printf("Using seed: %i\n", seed);
+   } else if (!strcmp(name, "headless")) {
+      // 0 would open a window, headless runs need at least one frame
+      int frames = countValue(name, value, 1);
+      if (frames < 0) {
+         return -1;
+      }
+      headlessFrames = (unsigned int)frames;
+      printf("Running headless for %u frames\n", headlessFrames);
+   } else if (!strcmp(name, "physics")) {
+      physicsEngine = findPhysicsEngine(value);
+      if (!physicsEngine) {
+         printf("Unknown physics engine: %s\n", value);
+         printEngines();
+         return -1;
+      }
+   } else if (!strcmp(name, "graphics")) {
+      graphicsEngine = findGraphicsEngine(value);
+      if (!graphicsEngine) {
+         printf("Unknown graphics engine: %s\n", value);
+         printEngines();
+         return -1;
+      }
+   } else if (!strcmp(name, "local")) {
+#ifdef HAVE_OPENCL
+      int number = countValue(name, value, 0);  // 1,16,32,64,256, 0 picks one
+      if (number < 0) {
+         return -1;
+      }
+      localSize = (size_t)number;
+      printf("Using localSize: %zu\n", localSize);
+#else
+      printf("Ignoring --local, built without OpenCL\n");
+#endif
+   } else if (!strcmp(name, "cl-profile")) {
+#ifdef HAVE_OPENCL
+      // "-" profiles without the per command CSV file
+      return openclEnableProfiling(strcmp(value, "-") ? value : "");
+#else
+      printf("Ignoring --cl-profile, built without OpenCL\n");
+#endif
+   } else if (!strcmp(name, "cl-precision")) {
+#ifdef HAVE_OPENCL
+      return openclSetPrecision(value);
+#else
+      printf("Ignoring --cl-precision, built without OpenCL\n");
+#endif
+   } else if (!strcmp(name, "integrator")) {
+      integrator = integratorFromName(value);
+      if (integrator < 0) {
+         printf("Unknown integrator: %s (euler, verlet, yoshida4, forest-ruth)\n", value);
+         return -1;
+      }
+   } else if (!strcmp(name, "adaptive")) {
+      // 0 switches back to equal steps
+      return realValue(name, value, 0.0, &adaptiveEta);
+   } else if (!strcmp(name, "simd")) {
+      simdLimit = simdFromName(value);
+      if (simdLimit < 0) {
+         printf("Unknown instruction set: %s (scalar, avx2, avx512)\n", value);
+         return -1;
+      }
+   } else if (!strcmp(name, "slices") || !strcmp(name, "parareal-coarse")) {
+      int number = countValue(name, value, 1);
+      if (number < 0) {
+         return -1;
+      }
+      if (!strcmp(name, "slices")) {
+         pararealSlices = number;
+      } else {
+         pararealCoarseSteps = number;
+      }
+   } else if (!strcmp(name, "parareal-tolerance")) {
+      return realValue(name, value, 0.0, &pararealConvergence);
+   } else if (!strcmp(name, "speculate")) {
+      // 0 switches speculation off
+      speculateThreads = countValue(name, value, 0);
+      if (speculateThreads < 0) {
+         return -1;
+      }
+   } else if (!strcmp(name, "ensemble")) {
+      ensembleSystems = countValue(name, value, 1);
+      if (ensembleSystems < 0) {
+         return -1;
+      }
+   } else if (!strcmp(name, "ensemble-output")) {
+      snprintf(ensemblePath, sizeof(ensemblePath), "%s", value);
+   } else if (!strcmp(name, "pipeline")) {
+      // 1 serial, 2 or 3 stages in flight
+      long long depth;
+      if (integerValue(name, value, 1, 3, &depth)) {
+         return -1;
+      }
+      pipelineDepth = (int)depth;
+   } else if (!strcmp(name, "checkpoint")) {
+      snprintf(checkpointPath, sizeof(checkpointPath), "%s", value);
+   } else if (!strcmp(name, "checkpoint-every")) {
+      // 0 only saves at the end
+      int every = countValue(name, value, 0);
+      if (every < 0) {
+         return -1;
+      }
+      checkpointEvery = (unsigned int)every;
+   } else if (!strcmp(name, "restore")) {
+      snprintf(restorePath, sizeof(restorePath), "%s", value);
+   } else if (!strcmp(name, "fast-forward")) {
+      int frame = countValue(name, value, 1);
+      if (frame < 0) {
+         return -1;
+      }
+      fastForwardFrame = (unsigned int)frame;
+   } else if (!strcmp(name, "calibrate")) {
+      // Above 0
+      return realValue(name, value, DBL_MIN, &calibrationTolerance);
+   } else if (!strcmp(name, "zero-copy")) {
+      // 0 draws every frame into pixels and copies it
+      long long number;
+      if (integerValue(name, value, 0, 1, &number)) {
+         return -1;
+      }
+      zeroCopy = (int)number;
+   } else if (!strcmp(name, "incremental")) {
+      // 0 switches the incremental distances off. Longer runs of
+      // additions go over the allowed error next to the satellite edges.
+      long long reseed;
+      if (integerValue(name, value, 0, 32, &reseed)) {
+         return -1;
+      }
+      incrementalReseed = (int)reseed;
+   } else if (!strcmp(name, "tile")) {
+      // 0 switches tiles off
+      graphicsTileSize = countValue(name, value, 0);
+      if (graphicsTileSize < 0) {
+         return -1;
+      }
+   } else if (!strcmp(name, "satellites") || !strcmp(name, "width") ||
+              !strcmp(name, "height") || !strcmp(name, "substeps") ||
+              !strcmp(name, "reference-substeps")) {
+      int number = countValue(name, value, 1);
+      if (number < 0) {
+         return -1;
+      }
+      if (!strcmp(name, "satellites")) {
+         satelliteCount = number;
+      } else if (!strcmp(name, "width")) {
+         windowWidth = number;
+      } else if (!strcmp(name, "height")) {
+         windowHeight = number;
+      } else if (!strcmp(name, "reference-substeps")) {
+         referenceUpdatesPerFrame = number;
+      } else {
+         physicsUpdatesPerFrame = number;
+      }
+   } else if (!strcmp(name, "config")) {
+      return readConfig(value);
+   } else if (!strcmp(name, "record")) {
+      return trajectoryStartRecording(value);
+   } else if (!strcmp(name, "replay")) {
+      return trajectoryLoad(value);
+   } else if (!strcmp(name, "sample-every")) {
+      // 0 switches sampling off
+      int every = countValue(name, value, 0);
+      if (every < 0) {
+         return -1;
+      }
+      sampleEvery = (unsigned int)every;
+   } else if (!strcmp(name, "sample-pixels")) {
+      samplePixels = countValue(name, value, 1);
+      if (samplePixels < 0) {
+         return -1;
+      }
+   } else if (!strcmp(name, "trace")) {
+      return traceOpen(value);
+   } else if (!strcmp(name, "report")) {
+      // value may be a line buffer of the config file
+      snprintf(reportPath, sizeof(reportPath), "%s", value);
+   } else {
+      printf("Unknown option: %s\n", name);
+      return -1;
+   }
+   return 0;
+}
+
+// Reads "name = value" lines (the '=' is optional), '#' starts a comment.
+// The value runs to the end of the line, without the outer whitespace.
+// The names are the command line options without the dashes, e.g.
+//    satellites = 4096
+//    width = 3840
+//    height = 2160
+static int readConfig(const char *path){
+   FILE *f = fopen(path, "r");
+   if (!f) {
+      printf("Cannot open config file: %s\n", path);
+      return -1;
+   }
+   char line[512];
+   int lineNumber = 0;
+   int result = 0;
+   while (!result && fgets(line, sizeof(line), f)) {
+      lineNumber++;
+      if (!strchr(line, '\n') && !feof(f)) {
+         printf("%s:%d: line longer than %d characters\n", path, lineNumber,
+                (int)sizeof(line) - 2);
+         result = -1;
+         break;
+      }
+      char *comment = strchr(line, '#');
+      if (comment) {
+         *comment = '\0';
+      }
+      char *p = line;
+      while (isspace((unsigned char)*p)) {
+         p++;
+      }
+      if (!*p) {
+         continue; // Empty line
+      }
+      char *name = p;
+      while (*p && *p != '=' && !isspace((unsigned char)*p)) {
+         p++;
+      }
+      char *nameEnd = p;
+      while (isspace((unsigned char)*p)) {
+         p++;
+      }
+      if (*p == '=') {
+         p++;
+         while (isspace((unsigned char)*p)) {
+            p++;
+         }
+      }
+      // The value is the rest of the line, so the option sees any junk
+      // after it and paths may contain spaces
+      char *value = p;
+      char *valueEnd = value + strlen(value);
+      while (valueEnd > value && isspace((unsigned char)valueEnd[-1])) {
+         valueEnd--;
+      }
+      *valueEnd = '\0';
+      *nameEnd = '\0';
+      if (name == nameEnd || !*value) {
+         printf("%s:%d: expected \"name = value\"\n", path, lineNumber);
+         result = -1;
+      } else {
+         result = applyOption(name, value);
+      }
+   }
+   fclose(f);
+   return result;
+}
+
+// Inits render window and starts mainloop
+int main(int argc, char** argv){
+   timingInit();
+
+   // The seed can also be given as the first argument without a name
+   if(argc > 1 && strncmp(argv[1], "--", 2)){
+     if (applyOption("seed", argv[1])) {
+        return 1;
+     }
+   }
+
+   // parse optional flags, later ones override earlier ones and the
+   // values of a --config file
+   for (int i = 1; i < argc; ++i) {
+      if (strncmp(argv[i], "--", 2)) {
+         if (i == 1) {
+            continue; // The seed
+         }
+         printf("Unexpected argument: %s\n", argv[i]);
+         return 1;
+      }
+      const char *name = argv[i] + 2;
+      if (!strcmp(name, "list-engines")) {
+         printEngines();
+         return 0;
+      }
+      if (takesValue(name) && i+1 >= argc) {
+         printf("Missing value for --%s\n", name);
+         return 1;
+      }
+      if (applyOption(name, takesValue(name) ? argv[++i] : "")) {
+         return 1;
+      }
+   }
+   // The reference keeps the default accuracy when the integrator is
+   // changed to run with fewer substeps
+   if (!referenceUpdatesPerFrame) {
+      referenceUpdatesPerFrame = integrator == INTEGRATOR_EULER ?
+         physicsUpdatesPerFrame : DEFAULT_PHYSICSUPDATESPERFRAME;
+   }
+
+   if (graphicsTileSize > 0 &&
+       (graphicsEngine == &sequentialGraphics || graphicsEngine == &openmpGraphics)) {
+      printf("Ignoring --tile, only the simd and opencl graphics draw in tiles\n");
+      graphicsTileSize = 0;
+   }
+   if (speculateThreads && pipelineDepth > 1) {
+      printf("Ignoring --speculate, the pipeline already runs the physics ahead\n");
+      speculateThreads = 0;
+   }
+#ifdef HAVE_OPENCL
+   if (physicsEngine == &openclPhysics && graphicsEngine == &openclGraphics) {
+      // Both would use the one satellite buffer at the same time
+      if (speculateThreads) {
+         printf("Ignoring --speculate, the opencl engines share their buffers\n");
+         speculateThreads = 0;
+      }
+      if (pipelineDepth > 1) {
+         printf("Ignoring --pipeline, the opencl engines share their buffers\n");
+         pipelineDepth = 1;
+      }
+   }
+#endif
+
+   if (calibrationTolerance > 0.0) {
+      // Only the initial satellites are needed, no engine or window
+      SDL_Init(SDL_INIT_TIMER);
+      fixedInit(seed);
+      int exitCode = calibrateIntegrators(satellites, satelliteCount,
+                                          headlessFrames ? headlessFrames : 10,
+                                          calibrationTolerance);
+      SDL_Quit();
+      fixedDestroy();
+      return exitCode;
+   }
+
+   if (ensembleSystems > 0) {
+      // Physics only, the seeds follow the given one (1 without a seed)
+      SDL_Init(SDL_INIT_TIMER);
+      physicsEngine->init();
+      int exitCode = runEnsemble(physicsEngine, ensembleSystems, seed ? seed : 1,
+                                 headlessFrames ? (int)headlessFrames : 10,
+                                 physicsTolerance(), ensemblePath);
+      physicsEngine->destroy();
+      traceClose();
+      SDL_Quit();
+      return exitCode;
+   }
+
+   if (restorePath[0] && loadRestore()) {
+      return 1;
+   }
+
+   printf("Simulating %d satellites at %dx%d with %d %s substeps per frame\n",
+          satelliteCount, windowWidth, windowHeight, physicsUpdatesPerFrame,
+          integratorName(integrator));
+   if (adaptiveEta > 0.0) {
+      printf("Adaptive steps of %g * sqrt(r^3 / GM), at most %d per frame\n",
+             adaptiveEta, physicsUpdatesPerFrame);
+   }
+   printf("Using physics engine: %s, graphics engine: %s\n",
+          physicsEngine->name, graphicsEngine->name);
+
+   if (headlessFrames) {
+      // No window or display, only the timer is needed
+      SDL_Init(SDL_INIT_TIMER);
+      fixedInit(seed);
+      startRun();
+      int exitCode = runHeadless();
+      SDL_Quit();
+      fixedDestroy();
+      return exitCode;
+   }
+
+   SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER);
+   win = SDL_CreateWindow(
+        "Satellites",
+        SDL_WINDOWPOS_UNDEFINED,
+        SDL_WINDOWPOS_UNDEFINED,
+        windowWidth, windowHeight,
+        0
+    );
+   surf = SDL_GetWindowSurface(win);
+   surfaceInit();
+
+   fixedInit(seed);
+   startRun();
+
+   SDL_Event event;
+   int running = 1;
+   while (running) {
+      while (SDL_PollEvent(&event)) switch (event.type) {
+         case SDL_QUIT:
+            printf("Quit called\n");
+            running = 0;
+            break;
+      }
+      runFrame();
+   }
+   pipelineFlush();
+   printTimingReport();
+   int exitCode = finishValidation();
+   SDL_Quit();
+   fixedDestroy();
+
+   return exitCode;
+}
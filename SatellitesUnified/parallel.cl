@@ -0,0 +1,489 @@
+#define EPS 1e-12
+
+// Stores 2D data like the coordinates
+typedef struct{
+   float x;
+   float y;
+} floatvector;
+
+// Each float may vary from 0.0f ... 1.0f
+typedef struct{
+   float blue;
+   float green;
+   float red;
+   float reserved;   // <— pad to 16 bytes
+} color_f32;
+
+// Stores the satellite data, which fly around black hole in the space
+typedef struct{
+   color_f32 identifier;
+   floatvector position;
+   floatvector velocity;
+} satellite;
+
+typedef struct {
+    int   substeps;
+    float gravity;
+    float dt;
+    int   mouseX;
+    int   mouseY;
+    int   satCount;
+    int   integrator;   // INTEGRATOR_* of integrator.h
+    float adaptiveEta;  // --adaptive, 0 for substeps equal steps
+} PhysParams;
+
+#define INTEGRATOR_EULER    0
+#define INTEGRATOR_VERLET   1
+#define INTEGRATOR_YOSHIDA4 2
+
+// w1 = 1 / (2 - 2^(1/3)) and w0 = -2^(1/3) * w1
+#define YOSHIDA_W1 1.3512071919596578
+#define YOSHIDA_W0 -1.7024143839193155
+
+typedef struct {
+    int   width;
+    int   height;
+    int   mouseX;
+    int   mouseY;
+    float blackHoleRadius2;
+    float satelliteRadius2;
+    int   satCount;
+} GraphicsParams;
+
+#ifdef HAVE_FP64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+
+// Gravity of the black hole at (mouseX, mouseY), same as integrator.c
+inline double2 gravity_at(double2 position, double2 mouse, double gravity)
+{
+    double2 positionToBlackHole = position - mouse;
+    double distToBlackHoleSquared = dot(positionToBlackHole, positionToBlackHole);
+    if (distToBlackHoleSquared < EPS) {
+        distToBlackHoleSquared = EPS;
+    }
+    double distToBlackHole = sqrt(distToBlackHoleSquared);
+    double accumulation = gravity / distToBlackHoleSquared;
+    return -accumulation * (positionToBlackHole / distToBlackHole);
+}
+
+// Kick - drift - kick, a is the force at p on entry and on return
+inline void verlet_step(double2 *p, double2 *v, double2 *a, double h,
+                        double2 mouse, double gravity)
+{
+    *v += *a * (0.5 * h);
+    *p += *v * h;
+    *a = gravity_at(*p, mouse, gravity);
+    *v += *a * (0.5 * h);
+}
+
+// Yoshida / Forest-Ruth: drift - kick - drift - kick - drift - kick - drift
+inline void yoshida_step(double2 *p, double2 *v, double h,
+                         double2 mouse, double gravity)
+{
+    const double drift0 = 0.5 * YOSHIDA_W1 * h;
+    const double drift1 = 0.5 * (YOSHIDA_W0 + YOSHIDA_W1) * h;
+    *p += *v * drift0;
+    *v += gravity_at(*p, mouse, gravity) * (YOSHIDA_W1 * h);
+    *p += *v * drift1;
+    *v += gravity_at(*p, mouse, gravity) * (YOSHIDA_W0 * h);
+    *p += *v * drift1;
+    *v += gravity_at(*p, mouse, gravity) * (YOSHIDA_W1 * h);
+    *p += *v * drift0;
+}
+
+// evaluations gets the force evaluations of every satellite with --adaptive
+__kernel void physics_compute(__global satellite* sats,
+                        __constant PhysParams* P,
+                        __global uint* evaluations)
+{
+    const uint i = get_global_id(0);
+    if ((int)i >= P->satCount) return;
+
+    const double dtStep = (double)P->dt / (double)P->substeps;
+
+
+    // Load to registers (float -> double for accuracy during accumulation)
+    double tmpPositionX = (double)sats[i].position.x;
+    double tmpPositionY = (double)sats[i].position.y;
+    double tmpVelocityX = (double)sats[i].velocity.x;
+    double tmpVelocityY = (double)sats[i].velocity.y;
+
+    const double tmpMousePosX = (double)P->mouseX;
+    const double tmpMousePosY = (double)P->mouseY;
+
+    const double GRAVITY = (double)P->gravity;
+
+    const double2 mouse = (double2)(tmpMousePosX, tmpMousePosY);
+    if (P->adaptiveEta > 0.0f) {
+        // Steps of eta * sqrt(r^3 / GM), at least dtStep (integrator.c)
+        double2 p = (double2)(tmpPositionX, tmpPositionY);
+        double2 v = (double2)(tmpVelocityX, tmpVelocityY);
+        double2 a = (double2)(0.0, 0.0);
+        uint count = 0;
+        if (P->integrator == INTEGRATOR_VERLET) {
+            a = gravity_at(p, mouse, GRAVITY);
+            count++;
+        }
+        double remaining = (double)P->dt;
+        while (remaining > 0.0) {
+            double r = length(p - mouse);
+            double h = (double)P->adaptiveEta * r * sqrt(r / GRAVITY);
+            if (!(h > dtStep)) {
+                h = dtStep;
+            }
+            if (h >= remaining) {
+                h = remaining;
+            }
+            if (P->integrator == INTEGRATOR_VERLET) {
+                verlet_step(&p, &v, &a, h, mouse, GRAVITY);
+                count++;
+            } else if (P->integrator == INTEGRATOR_YOSHIDA4) {
+                yoshida_step(&p, &v, h, mouse, GRAVITY);
+                count += 3;
+            } else {
+                a = gravity_at(p, mouse, GRAVITY);
+                v += a * h;
+                p += v * h;
+                count++;
+            }
+            remaining -= h;
+        }
+        evaluations[i] = count;
+        tmpPositionX = p.x; tmpPositionY = p.y;
+        tmpVelocityX = v.x; tmpVelocityY = v.y;
+    } else if (P->integrator == INTEGRATOR_VERLET) {
+        double2 p = (double2)(tmpPositionX, tmpPositionY);
+        double2 v = (double2)(tmpVelocityX, tmpVelocityY);
+        double2 a = gravity_at(p, mouse, GRAVITY);
+        for (int s = 0; s < P->substeps; ++s) {
+            verlet_step(&p, &v, &a, dtStep, mouse, GRAVITY);
+        }
+        tmpPositionX = p.x; tmpPositionY = p.y;
+        tmpVelocityX = v.x; tmpVelocityY = v.y;
+    } else if (P->integrator == INTEGRATOR_YOSHIDA4) {
+        double2 p = (double2)(tmpPositionX, tmpPositionY);
+        double2 v = (double2)(tmpVelocityX, tmpVelocityY);
+        for (int s = 0; s < P->substeps; ++s) {
+            yoshida_step(&p, &v, dtStep, mouse, GRAVITY);
+        }
+        tmpPositionX = p.x; tmpPositionY = p.y;
+        tmpVelocityX = v.x; tmpVelocityY = v.y;
+    } else {
+        for (int s = 0; s < P->substeps; ++s) {
+            // Distance to the blackhole
+            double positionToBlackHoleX = tmpPositionX - tmpMousePosX;
+            double positionToBlackHoleY = tmpPositionY - tmpMousePosY;
+            double distToBlackHoleSquared = positionToBlackHoleX*positionToBlackHoleX +
+                                            positionToBlackHoleY*positionToBlackHoleY;
+            if (distToBlackHoleSquared < EPS) {
+                // do a tiny clamp for ZERO distToBlackHole
+                distToBlackHoleSquared = EPS;
+            }
+
+            // Normalize direction and compute inverse powers
+            double distToBlackHole  = sqrt(distToBlackHoleSquared);
+
+            double normalizedDirectionX = positionToBlackHoleX / distToBlackHole;
+            double normalizedDirectionY = positionToBlackHoleY / distToBlackHole;
+
+            double accumulation = GRAVITY / distToBlackHoleSquared;
+
+            tmpVelocityX -= accumulation * normalizedDirectionX * dtStep;
+            tmpVelocityY -= accumulation * normalizedDirectionY * dtStep;
+
+            tmpPositionX += tmpVelocityX * dtStep;
+            tmpPositionY += tmpVelocityY * dtStep;
+        }
+    }
+
+    // Store back as float
+    sats[i].position.x = (float)tmpPositionX;
+    sats[i].position.y = (float)tmpPositionY;
+    sats[i].velocity.x = (float)tmpVelocityX;
+    sats[i].velocity.y = (float)tmpVelocityY;
+}
+#endif // HAVE_FP64
+
+#ifdef PHYSICS_FLOAT
+// Float only physics for devices without fp64 or with slow fp64. The
+// position and velocity are two-float numbers hi + lo, about 48 bits of
+// mantissa: the increment of one substep is far below the float
+// resolution of the position, a plain float sum would lose it. The force
+// itself only needs float. This program is built without
+// -cl-fast-relaxed-math and contraction, they would remove the rounding
+// error terms.
+#pragma OPENCL FP_CONTRACT OFF
+
+#define EPS_F 1e-12f
+#define YOSHIDA_W1_F 1.3512071919596578f
+#define YOSHIDA_W0_F -1.7024143839193155f
+
+typedef struct {
+    float2 hi;
+    float2 lo;
+} float2x2;
+
+inline float2x2 ff_from(float2 a)
+{
+    float2x2 r;
+    r.hi = a;
+    r.lo = (float2)(0.0f, 0.0f);
+    return r;
+}
+
+// a + b, the rounding error of the sum goes to lo (two-sum)
+inline float2x2 ff_add(float2x2 a, float2 b)
+{
+    float2 s = a.hi + b;
+    float2 bb = s - a.hi;
+    float2 e = ((a.hi - (s - bb)) + (b - bb)) + a.lo;
+    float2x2 r;
+    r.hi = s + e;
+    r.lo = e - (r.hi - s);
+    return r;
+}
+
+// a * h rounded to float, precise enough for an increment
+inline float2 ff_scale(float2x2 a, float h)
+{
+    return a.hi * h + a.lo * h;
+}
+
+inline float2 gravity_at_ff(float2x2 position, float2 mouse, float gravity)
+{
+    float2 positionToBlackHole = (position.hi - mouse) + position.lo;
+    float distToBlackHoleSquared = positionToBlackHole.x * positionToBlackHole.x +
+                                   positionToBlackHole.y * positionToBlackHole.y;
+    if (distToBlackHoleSquared < EPS_F) {
+        distToBlackHoleSquared = EPS_F;
+    }
+    float distToBlackHole = sqrt(distToBlackHoleSquared);
+    float accumulation = gravity / distToBlackHoleSquared;
+    return -accumulation * (positionToBlackHole / distToBlackHole);
+}
+
+inline void verlet_step_ff(float2x2 *p, float2x2 *v, float2 *a, float h,
+                           float2 mouse, float gravity)
+{
+    *v = ff_add(*v, *a * (0.5f * h));
+    *p = ff_add(*p, ff_scale(*v, h));
+    *a = gravity_at_ff(*p, mouse, gravity);
+    *v = ff_add(*v, *a * (0.5f * h));
+}
+
+inline void yoshida_step_ff(float2x2 *p, float2x2 *v, float h,
+                            float2 mouse, float gravity)
+{
+    const float drift0 = 0.5f * YOSHIDA_W1_F * h;
+    const float drift1 = 0.5f * (YOSHIDA_W0_F + YOSHIDA_W1_F) * h;
+    *p = ff_add(*p, ff_scale(*v, drift0));
+    *v = ff_add(*v, gravity_at_ff(*p, mouse, gravity) * (YOSHIDA_W1_F * h));
+    *p = ff_add(*p, ff_scale(*v, drift1));
+    *v = ff_add(*v, gravity_at_ff(*p, mouse, gravity) * (YOSHIDA_W0_F * h));
+    *p = ff_add(*p, ff_scale(*v, drift1));
+    *v = ff_add(*v, gravity_at_ff(*p, mouse, gravity) * (YOSHIDA_W1_F * h));
+    *p = ff_add(*p, ff_scale(*v, drift0));
+}
+
+// Same arguments and integrators as physics_compute
+__kernel void physics_compute_float(__global satellite* sats,
+                        __constant PhysParams* P,
+                        __global uint* evaluations)
+{
+    const uint i = get_global_id(0);
+    if ((int)i >= P->satCount) return;
+
+    const float dtStep = P->dt / (float)P->substeps;
+    const float GRAVITY = P->gravity;
+    const float2 mouse = (float2)((float)P->mouseX, (float)P->mouseY);
+
+    float2x2 p = ff_from((float2)(sats[i].position.x, sats[i].position.y));
+    float2x2 v = ff_from((float2)(sats[i].velocity.x, sats[i].velocity.y));
+
+    if (P->adaptiveEta > 0.0f) {
+        float2 a = (float2)(0.0f, 0.0f);
+        uint count = 0;
+        if (P->integrator == INTEGRATOR_VERLET) {
+            a = gravity_at_ff(p, mouse, GRAVITY);
+            count++;
+        }
+        float remaining = P->dt;
+        while (remaining > 0.0f) {
+            float r = length((p.hi - mouse) + p.lo);
+            float h = P->adaptiveEta * r * sqrt(r / GRAVITY);
+            if (!(h > dtStep)) {
+                h = dtStep;
+            }
+            if (h >= remaining) {
+                h = remaining;
+            }
+            if (P->integrator == INTEGRATOR_VERLET) {
+                verlet_step_ff(&p, &v, &a, h, mouse, GRAVITY);
+                count++;
+            } else if (P->integrator == INTEGRATOR_YOSHIDA4) {
+                yoshida_step_ff(&p, &v, h, mouse, GRAVITY);
+                count += 3;
+            } else {
+                v = ff_add(v, gravity_at_ff(p, mouse, GRAVITY) * h);
+                p = ff_add(p, ff_scale(v, h));
+                count++;
+            }
+            remaining -= h;
+        }
+        evaluations[i] = count;
+    } else if (P->integrator == INTEGRATOR_VERLET) {
+        float2 a = gravity_at_ff(p, mouse, GRAVITY);
+        for (int s = 0; s < P->substeps; ++s) {
+            verlet_step_ff(&p, &v, &a, dtStep, mouse, GRAVITY);
+        }
+    } else if (P->integrator == INTEGRATOR_YOSHIDA4) {
+        for (int s = 0; s < P->substeps; ++s) {
+            yoshida_step_ff(&p, &v, dtStep, mouse, GRAVITY);
+        }
+    } else {
+        for (int s = 0; s < P->substeps; ++s) {
+            v = ff_add(v, gravity_at_ff(p, mouse, GRAVITY) * dtStep);
+            p = ff_add(p, ff_scale(v, dtStep));
+        }
+    }
+
+    // Store back as float
+    float2 position = p.hi + p.lo;
+    float2 velocity = v.hi + v.lo;
+    sats[i].position.x = position.x;
+    sats[i].position.y = position.y;
+    sats[i].velocity.x = velocity.x;
+    sats[i].velocity.y = velocity.y;
+}
+#endif // PHYSICS_FLOAT
+
+// Color of pixel (w, h). With testDiscs 0 the pixel is known to be
+// outside the black hole and every satellite, only the field is summed.
+inline uchar4 shade_pixel(__global const satellite* sats,
+                          __constant GraphicsParams* P,
+                          int w, int h, int testDiscs)
+{
+    // Draw the black hole
+    const float positionToBlackHoleX = (float)w - (float)P->mouseX;
+    const float positionToBlackHoleY = (float)h - (float)P->mouseY;
+    const float distToBlackHoleSquared =
+       positionToBlackHoleX*positionToBlackHoleX +
+       positionToBlackHoleY*positionToBlackHoleY;
+
+    if (testDiscs && distToBlackHoleSquared < P->blackHoleRadius2) {
+        return (uchar4)(0,0,0,255);// Black hole drawing done
+    }
+
+    // This color is used for coloring the pixel
+    float renderColorBlue=0.0f, renderColorGreen=0.0f, renderColorRed=0.0f;
+
+    // Find closest satellite
+    float shortestDistanceSquared = INFINITY;
+    float weights = 0.0f;
+    float rb = 0.f, rg = 0.f, rr = 0.f;
+    int hitsSatellite = 0;
+
+    // One graphics satellite loop: each satellite is read and its distance
+    // and weight computed once, for the closest satellite, the total
+    // weight and the weighted colors. No break on a hit, so the work-items
+    // of a wave stay together.
+    for (int j = 0; j < P->satCount; ++j) {
+        const satellite s = sats[j];
+        const float differenceX = (float)w - s.position.x;
+        const float differenceY = (float)h - s.position.y;
+        const float distanceSquared = differenceX*differenceX +
+                                      differenceY*differenceY;
+        if (testDiscs) {
+            hitsSatellite |= distanceSquared < P->satelliteRadius2;
+        }
+
+        const float weight = 1.0f / (distanceSquared * distanceSquared);
+        weights += weight;
+        rb += s.identifier.blue * weight;
+        rg += s.identifier.green * weight;
+        rr += s.identifier.red * weight;
+
+        if (distanceSquared < shortestDistanceSquared) {
+            shortestDistanceSquared = distanceSquared;
+            renderColorBlue = s.identifier.blue;
+            renderColorGreen = s.identifier.green;
+            renderColorRed = s.identifier.red;
+        }
+    }
+
+    if (hitsSatellite) {
+        renderColorBlue = 1.0f; // inside a satellite → white
+        renderColorGreen = 1.0f;
+        renderColorRed = 1.0f;
+    } else {
+        renderColorBlue += rb * 3.0f / weights;
+        renderColorGreen += rg * 3.0f / weights;
+        renderColorRed += rr * 3.0f / weights;
+    }
+
+    // clamp to the valid range before cast
+    renderColorBlue  = clamp(renderColorBlue,  0.0f, 1.0f);
+    renderColorGreen = clamp(renderColorGreen, 0.0f, 1.0f);
+    renderColorRed   = clamp(renderColorRed,   0.0f, 1.0f);
+
+    return (uchar4)((uchar)(renderColorBlue*255.0f),
+                    (uchar)(renderColorGreen*255.0f),
+                    (uchar)(renderColorRed*255.0f),
+                    (uchar)255);
+}
+
+__kernel void graphics_render(__global const satellite* sats,
+                     __constant GraphicsParams* P,
+                     __global uchar4* pixels)
+{
+    const int gid = get_global_id(0);
+    const int total = P->width * P->height;
+    if (gid >= total) return;
+
+    pixels[gid] = shade_pixel(sats, P, gid % P->width, gid / P->width, 1);
+}
+
+// One work-group per tile of --tile x --tile pixels. The group first
+// checks whether any satellite or the black hole can touch its tile, the
+// work-items splitting the satellites between them and reading them from
+// global memory. A hit sets the shared flag with an atomic, as several
+// work-items may find one at once. Most tiles are touched by nothing
+// and the whole group takes the field only path, the others the full one,
+// so the work-items of a group never diverge.
+__kernel void graphics_render_tiled(__global const satellite* sats,
+                     __constant GraphicsParams* P,
+                     __global uchar4* pixels)
+{
+    __local int tileTouched;
+    const int w = get_global_id(0);
+    const int h = get_global_id(1);
+    const int lid = get_local_id(1) * get_local_size(0) + get_local_id(0);
+    const int groupSize = get_local_size(0) * get_local_size(1);
+
+    // Tile bounds, one pixel of margin for the rounding of the distances
+    const float left = (float)(get_group_id(0) * get_local_size(0)) - 1.0f;
+    const float top = (float)(get_group_id(1) * get_local_size(1)) - 1.0f;
+    const float right = left + (float)get_local_size(0) + 1.0f;
+    const float bottom = top + (float)get_local_size(1) + 1.0f;
+    const float satelliteRadius = sqrt(P->satelliteRadius2);
+    const float blackHoleRadius = sqrt(P->blackHoleRadius2);
+
+    if (lid == 0) {
+        tileTouched = (float)P->mouseX > left - blackHoleRadius &&
+                      (float)P->mouseX < right + blackHoleRadius &&
+                      (float)P->mouseY > top - blackHoleRadius &&
+                      (float)P->mouseY < bottom + blackHoleRadius;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int j = lid; j < P->satCount; j += groupSize) {
+        const float2 position = (float2)(sats[j].position.x, sats[j].position.y);
+        if (position.x > left - satelliteRadius && position.x < right + satelliteRadius &&
+            position.y > top - satelliteRadius && position.y < bottom + satelliteRadius) {
+            atomic_or(&tileTouched, 1);
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (w >= P->width || h >= P->height) return;
+    pixels[h * P->width + w] = shade_pixel(sats, P, w, h, tileTouched);
+}
@@ -0,0 +1,76 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipeline.h"
+
+struct PipelineWorker {
+   SDL_Thread *thread;
+   SDL_sem *kicked;
+   SDL_sem *finished;
+   SDL_atomic_t stopping;
+   int running;            // kicked and not waited for, caller thread only
+   void (*stage)(void *data);
+   void *data;
+};
+
+static int workerThread(void *data){
+   PipelineWorker *worker = (PipelineWorker*)data;
+   for (;;) {
+      SDL_SemWait(worker->kicked);
+      // Without a run the wake up is from pipelineWorkerStop()
+      if (SDL_AtomicGet(&worker->stopping)) {
+         break;
+      }
+      worker->stage(worker->data);
+      SDL_SemPost(worker->finished);
+   }
+   return 0;
+}
+
+PipelineWorker *pipelineWorkerStart(const char *name, void (*stage)(void *data), void *data){
+   PipelineWorker *worker = (PipelineWorker*)calloc(1, sizeof(PipelineWorker));
+   if (!worker) {
+      printf("Out of memory for the %s worker\n", name);
+      exit(-1);
+   }
+   worker->stage = stage;
+   worker->data = data;
+   SDL_AtomicSet(&worker->stopping, 0);
+   worker->kicked = SDL_CreateSemaphore(0);
+   worker->finished = SDL_CreateSemaphore(0);
+   worker->thread = SDL_CreateThread(workerThread, name, worker);
+   return worker;
+}
+
+void pipelineWorkerKick(PipelineWorker *worker){
+   worker->running = 1;
+   SDL_SemPost(worker->kicked);
+}
+
+void pipelineWorkerWait(PipelineWorker *worker){
+   if (worker->running) {
+      SDL_SemWait(worker->finished);
+      worker->running = 0;
+   }
+}
+
+void pipelineWorkerStop(PipelineWorker *worker){
+   if (!worker) {
+      return;
+   }
+   pipelineWorkerWait(worker);
+   SDL_AtomicSet(&worker->stopping, 1);
+   SDL_SemPost(worker->kicked);
+   SDL_WaitThread(worker->thread, NULL);
+   SDL_DestroySemaphore(worker->kicked);
+   SDL_DestroySemaphore(worker->finished);
+   free(worker);
+}
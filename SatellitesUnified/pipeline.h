@@ -0,0 +1,25 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Pipelined frame loop ¤¤                                      //
+//                                                                    //
+//    With --pipeline the stages of consecutive frames overlap: the   //
+//    physics of frame N+1 runs on one worker while the graphics of   //
+//    frame N runs on another, and at depth 3 the main thread shows   //
+//    frame N-1 meanwhile. The satellites and pixels are double       //
+//    buffered between the stages, see pipelineFrame() in parallel.c  //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// A thread that runs its stage once per pipelineWorkerKick()
+typedef struct PipelineWorker PipelineWorker;
+
+PipelineWorker *pipelineWorkerStart(const char *name, void (*stage)(void *data), void *data);
+// Starts one run of the stage, the previous one must have been waited for
+void pipelineWorkerKick(PipelineWorker *worker);
+// Waits until the run started by the last kick has finished
+void pipelineWorkerWait(PipelineWorker *worker);
+// Stops the thread and frees the worker, NULL is ignored
+void pipelineWorkerStop(PipelineWorker *worker);
+
+#endif // PIPELINE_H
@@ -0,0 +1,242 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "sampler.h"
+#include "timing.h"
+#include "trace.h"
+#include "validation.h"
+
+// Everything the thread needs to check one frame
+typedef struct {
+   unsigned int frame;
+   int mouseX;
+   int mouseY;
+   int width;
+   int satelliteIndex;
+   satellite before;       // the sampled satellite before physics
+   satellite after;        // and after the engine physics
+   satellite *sats;        // all satellites after physics, for the pixels
+   int satelliteCount;
+   int satelliteCapacity;
+   int *pixelIndices;
+   color_u8 *enginePixels;
+   int pixelCount;
+} SampleJob;
+
+static unsigned int sampleEvery = 0;
+static int samplePixels = 0;
+static SampleJob job;
+static int armed = 0;           // the current frame is being sampled
+static uint32_t randomState = 1;
+
+static SDL_Thread *thread = NULL;
+static SDL_sem *jobReady = NULL;
+static SDL_atomic_t busy;       // job is owned by the thread
+
+// Written by the thread only, read after samplerDestroy()
+static ValidationReport report;
+static unsigned int alarms = 0;
+static unsigned int samples = 0;
+static unsigned int skipped = 0;
+static uint64_t threadTime = 0;
+// Time the frame loop spends in the hooks
+static uint64_t hookTime = 0;
+
+// xorshift32, separate from rand() so the satellites stay the same
+static uint32_t nextRandom(void){
+   randomState ^= randomState << 13;
+   randomState ^= randomState >> 17;
+   randomState ^= randomState << 5;
+   return randomState;
+}
+
+static void runSample(SampleJob *j){
+   uint64_t start = timingNow();
+
+   // Physics of the sampled satellite alone gives the same result,
+   // satellites do not affect each other
+   satellite reference = j->before;
+   sequentialPhysicsEngine(&reference, 1, j->mouseX, j->mouseY);
+   int satelliteDrift = validationAddSatellite(&report, &reference, &j->after,
+                                               j->satelliteIndex, j->frame);
+   double positionError = hypot((double)j->after.position.x - reference.position.x,
+                                (double)j->after.position.y - reference.position.y);
+   report.satelliteFrames++;
+
+   int wrongPixels = 0;
+   for (int i = 0; i < j->pixelCount; ++i) {
+      int index = j->pixelIndices[i];
+      color_u8 correct = sequentialPixel(j->sats, j->satelliteCount, j->mouseX, j->mouseY,
+                                         index % j->width, index / j->width);
+      wrongPixels += validationAddPixel(&report, correct, j->enginePixels[i]);
+   }
+   report.pixelFrames++;
+
+   if (wrongPixels) {
+      report.failedPixelFrames++;
+   }
+   if (satelliteDrift) {
+      report.failedSatelliteFrames++;
+   }
+   if (wrongPixels || satelliteDrift) {
+      alarms++;
+      printf("Drift alarm in frame %u: %d of %d sampled pixels over allowed error, "
+             "satellite %d off by %.3g pixels\n",
+             j->frame, wrongPixels, j->pixelCount, j->satelliteIndex, positionError);
+   }
+   samples++;
+   uint64_t end = timingNow();
+   traceSpan("sample", "validation", TRACE_TID_SAMPLER, start, end, "frame", j->frame);
+   threadTime += end - start;
+}
+
+static int samplerThread(void *data){
+   (void)data;
+   for (;;) {
+      SDL_SemWait(jobReady);
+      // Without a job the wake up is from samplerDestroy()
+      if (!SDL_AtomicGet(&busy)) {
+         break;
+      }
+      runSample(&job);
+      SDL_AtomicSet(&busy, 0);
+   }
+   return 0;
+}
+
+void samplerInit(unsigned int every, int pixels, unsigned int seed, double tolerance){
+   validationReset(&report);
+   report.satelliteTolerance = tolerance > SAMPLE_POSITION_TOLERANCE ?
+      tolerance : SAMPLE_POSITION_TOLERANCE;
+   sampleEvery = every;
+   if (!sampleEvery) {
+      return;
+   }
+   randomState = seed ? seed : 0x9e3779b9u;
+   samplePixels = pixels;
+   job.pixelCount = pixels;
+   job.pixelIndices = (int*)malloc(sizeof(int) * pixels);
+   job.enginePixels = (color_u8*)malloc(sizeof(color_u8) * pixels);
+   if (!job.pixelIndices || !job.enginePixels) {
+      printf("Out of memory for %d sampled pixels\n", pixels);
+      exit(-1);
+   }
+   SDL_AtomicSet(&busy, 0);
+   jobReady = SDL_CreateSemaphore(0);
+   thread = SDL_CreateThread(samplerThread, "sampler", NULL);
+   printf("Sampling %d pixels and 1 satellite every %u frames\n", pixels, sampleEvery);
+}
+
+void samplerBeforePhysics(unsigned int frame, const satellite *sats, int count){
+   // The first two frames are checked completely
+   if (!sampleEvery || frame < 2 || frame % sampleEvery) {
+      return;
+   }
+   if (armed || SDL_AtomicGet(&busy)) {
+      skipped++;
+      return;
+   }
+   uint64_t start = timingNow();
+   armed = 1;
+   job.frame = frame;
+   job.satelliteIndex = (int)(nextRandom() % (uint32_t)count);
+   job.before = sats[job.satelliteIndex];
+   hookTime += timingNow() - start;
+}
+
+void samplerAfterPhysics(unsigned int frame, const satellite *sats, int count){
+   if (!armed || frame != job.frame) {
+      return;
+   }
+   uint64_t start = timingNow();
+   if (count > job.satelliteCapacity) {
+      free(job.sats);
+      job.sats = (satellite*)malloc(sizeof(satellite) * count);
+      if (!job.sats) {
+         printf("Out of memory for %d sampled satellites\n", count);
+         exit(-1);
+      }
+      job.satelliteCapacity = count;
+   }
+   memcpy(job.sats, sats, sizeof(satellite) * count);
+   job.satelliteCount = count;
+   job.after = sats[job.satelliteIndex];
+   hookTime += timingNow() - start;
+}
+
+void samplerAfterGraphics(unsigned int frame, const color_u8 *pixels, int width, int height,
+                          int stride, int mouseX, int mouseY){
+   if (!armed || frame != job.frame) {
+      return;
+   }
+   uint64_t start = timingNow();
+   job.width = width;
+   job.mouseX = mouseX;
+   job.mouseY = mouseY;
+   for (int i = 0; i < job.pixelCount; ++i) {
+      int index = (int)(nextRandom() % (uint32_t)(width * height));
+      job.pixelIndices[i] = index;
+      job.enginePixels[i] = pixels[index / width * stride + index % width];
+   }
+   armed = 0;
+   SDL_AtomicSet(&busy, 1);
+   SDL_SemPost(jobReady);
+   hookTime += timingNow() - start;
+}
+
+void samplerDestroy(void){
+   if (!thread) {
+      return;
+   }
+   // Queued after a possible job, the thread finishes that one first
+   SDL_SemPost(jobReady);
+   SDL_WaitThread(thread, NULL);
+   SDL_DestroySemaphore(jobReady);
+   thread = NULL;
+   free(job.sats);
+   free(job.pixelIndices);
+   free(job.enginePixels);
+   memset(&job, 0, sizeof(job));
+}
+
+uint32_t samplerRandomState(void){
+   return randomState;
+}
+
+void samplerSetRandomState(uint32_t state){
+   if (state) {
+      randomState = state;
+   }
+}
+
+int samplerPassed(void){
+   return alarms == 0;
+}
+
+void samplerPrint(uint64_t frameTimeNs){
+   if (!sampleEvery) {
+      return;
+   }
+   validationPrint("Sampled correctness", &report);
+   printf("  %u samples, %u skipped while busy, %u drift alarms\n", samples, skipped, alarms);
+   printf("  frame loop cost %.3f ms (%.3f%% of frame time), sampler thread %.3f ms\n",
+          hookTime / 1e6, frameTimeNs ? 100.0 * hookTime / frameTimeNs : 0.0,
+          threadTime / 1e6);
+}
+
+void samplerPrintJson(FILE *f){
+   fprintf(f, "{\"every\":%u,\"pixels_per_sample\":%d,\"samples\":%u,\"skipped\":%u,"
+              "\"alarms\":%u,\"frame_loop_ms\":%.6f,\"thread_ms\":%.6f,\"report\":",
+           sampleEvery, samplePixels, samples, skipped, alarms,
+           hookTime / 1e6, threadTime / 1e6);
+   validationPrintJson(f, &report);
+   fprintf(f, "}");
+}
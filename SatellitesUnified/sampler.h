@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Sampled correctness checks ¤¤                                //
+//                                                                    //
+//    Every N frames a few random pixels and one random satellite     //
+//    are compared to the sequential reference code on a separate     //
+//    thread, so that all frames after the first two are covered too  //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "satellites.h"
+
+// A sampled satellite further than this (or the tolerance of the physics
+// engine, if larger) from the reference after one frame raises a drift
+// alarm, pixels raise one when over ALLOWED_ERROR
+#define SAMPLE_POSITION_TOLERANCE 0.01
+
+// Starts the thread, checks every `every` frames (0 disables sampling)
+// `pixels` random pixels and one satellite. seed makes the picks repeatable.
+void samplerInit(unsigned int every, int pixels, unsigned int seed, double tolerance);
+
+// Hooks of the frame loop. A sample is only taken when the thread has
+// finished the previous one, otherwise the frame is skipped. With
+// --pipeline the hooks of neighbouring frames interleave, the after hooks
+// only act on the frame being sampled and no other frame is armed until
+// its graphics are done. Rows of pixels are stride pixels apart.
+void samplerBeforePhysics(unsigned int frame, const satellite *sats, int count);
+void samplerAfterPhysics(unsigned int frame, const satellite *sats, int count);
+void samplerAfterGraphics(unsigned int frame, const color_u8 *pixels, int width, int height,
+                          int stride, int mouseX, int mouseY);
+
+// Waits for the last sample and stops the thread
+void samplerDestroy(void);
+
+// State of the random picks, kept in checkpoints so that a restored run
+// samples the same frames as an uninterrupted one
+uint32_t samplerRandomState(void);
+void samplerSetRandomState(uint32_t state);
+
+// 0 when a drift alarm was raised
+int samplerPassed(void);
+// Summary, frameTimeNs is the total frame time for the overhead share
+void samplerPrint(uint64_t frameTimeNs);
+// {...} JSON object
+void samplerPrintJson(FILE *f);
+
+#endif // SAMPLER_H
@@ -0,0 +1,204 @@
+/* COMP.CE.350 Parallelization Excercise 2024
+   Copyright (c) 2016 Matias Koskela matias.koskela@tut.fi
+                      Heikki Kultala heikki.kultala@tut.fi
+                      Topi Leppanen  topi.leppanen@tuni.fi
+*/
+
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Shared definitions of the unified satellite simulation ¤¤    //
+//                                                                    //
+//    Types and constants used by parallel.c and by every engine      //
+//    (engine_sequential.c, engine_openmp.c, engine_opencl.c)         //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef SATELLITES_H
+#define SATELLITES_H
+
+#include <assert.h> // static_assert
+#include <stddef.h>
+#include <stdint.h> // uint8_t
+#include <stdio.h> // FILE
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+
+// Default sizes. They can be changed at runtime with --satellites, --width,
+// --height and --substeps or with a --config file (see parallel.c)
+
+// These are used to decide the window size
+#define DEFAULT_WINDOW_HEIGHT 1024
+#define DEFAULT_WINDOW_WIDTH  1920
+
+// The number of satellites can be changed to see how it affects performance.
+// Benchmarks must be run with the original number of satellites
+#define DEFAULT_SATELLITE_COUNT 64
+
+// These are used to control the satellite movement
+#define SATELLITE_RADIUS 3.16f
+#define MAX_VELOCITY 0.1f
+#define GRAVITY 1.0f
+#define DELTATIME 32
+#define DEFAULT_PHYSICSUPDATESPERFRAME 100000
+#define BLACK_HOLE_RADIUS 4.5f
+
+// Sizes in use, set once at startup (parallel.c)
+extern int windowWidth;
+extern int windowHeight;
+extern int satelliteCount;
+extern int physicsUpdatesPerFrame;
+// Euler substeps of the sequential reference code. Same as
+// physicsUpdatesPerFrame unless a higher order --integrator is used
+extern int referenceUpdatesPerFrame;
+// Tile edge in pixels of the simd and opencl graphics (--tile), 0 draws
+// without tiles
+extern int graphicsTileSize;
+
+#define SIZE (windowWidth*windowHeight)
+#define HORIZONTAL_CENTER (windowWidth / 2)
+#define VERTICAL_CENTER (windowHeight / 2)
+
+// Satellite and pixel buffers are aligned to a cache line, which is also
+// the widest vector load (AVX-512)
+#define BUFFER_ALIGNMENT 64
+
+static inline void *alignedAlloc(size_t bytes){
+#ifdef _WIN32
+   return _aligned_malloc(bytes ? bytes : 1, BUFFER_ALIGNMENT);
+#else
+   void *buffer = NULL;
+   if (posix_memalign(&buffer, BUFFER_ALIGNMENT, bytes ? bytes : 1)) {
+      return NULL;
+   }
+   return buffer;
+#endif
+}
+
+static inline void alignedFree(void *buffer){
+#ifdef _WIN32
+   _aligned_free(buffer);
+#else
+   free(buffer);
+#endif
+}
+
+// Stores 2D data like the coordinates
+typedef struct{
+   float x;
+   float y;
+} floatvector;
+
+// Stores 2D data like the coordinates
+typedef struct{
+   double x;
+   double y;
+} doublevector;
+
+// Each float may vary from 0.0f ... 1.0f
+typedef struct{
+   float blue;
+   float green;
+   float red;
+   float reserved;   // <— pad to 16 bytes, same layout as in parallel.cl
+} color_f32;
+static_assert(sizeof(color_f32) == 4*4, "color_f32 must be 16 bytes");
+
+// Stores rendered colors. Each value may vary from 0 ... 255
+typedef struct{
+   uint8_t blue;
+   uint8_t green;
+   uint8_t red;
+   uint8_t reserved;
+} color_u8;
+
+// Stores the satellite data, which fly around black hole in the space
+typedef struct{
+   color_f32 identifier;
+   floatvector position;
+   floatvector velocity;
+} satellite;
+static_assert(sizeof(satellite) == 8*4, "satellite must be 32 bytes");
+
+
+// Physics engine interface.
+// run() moves count satellites in sats by one frame around the
+// black hole at (mouseX, mouseY).
+// tolerance is 0 for engines that must match the sequential reference bit
+// by bit, approximate engines give the allowed position error in pixels.
+typedef struct {
+   const char *name;
+   void (*init)(void);
+   void (*destroy)(void);
+   void (*run)(satellite *sats, int count, int mouseX, int mouseY);
+   double tolerance;
+} PhysicsEngine;
+
+// Graphics engine interface.
+// run() colors all SIZE pixels of out based on count satellites and the
+// black hole at (mouseX, mouseY). Rows of out are stride pixels apart,
+// windowWidth except when drawing straight into the window surface.
+typedef struct {
+   const char *name;
+   void (*init)(void);
+   void (*destroy)(void);
+   void (*run)(const satellite *sats, int count, int mouseX, int mouseY, color_u8 *out,
+               int stride);
+} GraphicsEngine;
+
+// parallel.c, sequential reference code used for finding errors
+color_u8 sequentialPixel(const satellite *sats, int count, int mouseX, int mouseY, int x, int y);
+void sequentialPhysicsEngine(satellite *s, int count, int mouseX, int mouseY);
+// Random satellites of fixedInit(), seeded with srand() by the caller
+void createSatellites(satellite *sats, int count);
+
+// engine_sequential.c
+extern const PhysicsEngine sequentialPhysics;
+extern const GraphicsEngine sequentialGraphics;
+
+// engine_openmp.c
+extern const PhysicsEngine openmpPhysics;
+extern const GraphicsEngine openmpGraphics;
+// Pixels between fresh satellite distances of the incremental row walk
+// (--incremental), 0 computes every distance from scratch
+extern int incrementalReseed;
+
+// engine_kepler.c
+extern const PhysicsEngine keplerPhysics;
+
+// engine_simd.c
+extern const PhysicsEngine simdPhysics;
+extern const GraphicsEngine simdGraphics;
+
+// engine_parareal.c
+extern const PhysicsEngine pararealPhysics;
+// --slices, --parareal-tolerance and --parareal-coarse
+extern int pararealSlices;
+extern double pararealConvergence;
+extern int pararealCoarseSteps;
+// Slice count and iterations of the frames run so far
+void pararealPrint(void);
+void pararealPrintJson(FILE *f);
+
+#ifdef HAVE_OPENCL
+// engine_opencl.c
+extern const PhysicsEngine openclPhysics;
+extern const GraphicsEngine openclGraphics;
+
+// OpenCL work-group size, 0 lets the runtime decide (--local)
+extern size_t localSize;
+
+// Event profiling of every OpenCL command (--cl-profile), must be
+// enabled before the engines are initialized. csvPath may be empty.
+extern int clProfiling;
+int openclEnableProfiling(const char *csvPath);
+void openclPrintProfile(void);
+void openclPrintProfileJson(FILE *f);
+
+// Precision of the physics kernel (--cl-precision auto, double or float),
+// must be set before the engines are initialized. Returns 0 on success.
+int openclSetPrecision(const char *name);
+// Allowed position error of the kernel picked by the physics init
+double openclPhysicsTolerance(void);
+#endif
+
+#endif // SATELLITES_H
@@ -0,0 +1,69 @@
+#include "simd.h"
+
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h> // __cpuidex
+#endif
+
+int simdLimit = SIMD_AVX512;
+
+static const char *simdNames[SIMD_LEVELS] = {"scalar", "avx2", "avx512"};
+
+// Widest level of the CPU, including the check that the operating system
+// saves the wide registers on a context switch
+static int detectLevel(void){
+#if defined(HAVE_SIMD_X86) && defined(__GNUC__)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f")) {
+      return SIMD_AVX512;
+   }
+   if (__builtin_cpu_supports("avx2")) {
+      return SIMD_AVX2;
+   }
+#elif defined(HAVE_SIMD_X86)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7) {
+      return SIMD_SCALAR;
+   }
+   __cpuid(info, 1);
+   int osxsave = (info[2] >> 27) & 1;
+   int avx = (info[2] >> 28) & 1;
+   if (!osxsave || !avx) {
+      return SIMD_SCALAR;
+   }
+   unsigned long long xcr0 = _xgetbv(0);
+   __cpuidex(info, 7, 0);
+   // ZMM, upper YMM and opmask state saved
+   if (((info[1] >> 16) & 1) && (xcr0 & 0xe6) == 0xe6) {
+      return SIMD_AVX512;
+   }
+   // YMM and XMM state saved
+   if (((info[1] >> 5) & 1) && (xcr0 & 0x6) == 0x6) {
+      return SIMD_AVX2;
+   }
+#endif
+   return SIMD_SCALAR;
+}
+
+int simdLevel(void){
+   static int detected = -1;
+   if (detected < 0) {
+      detected = detectLevel();
+   }
+   return detected < simdLimit ? detected : simdLimit;
+}
+
+int simdFromName(const char *name){
+   for (int i = 0; i < SIMD_LEVELS; ++i) {
+      if (!strcmp(simdNames[i], name)) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+const char *simdName(int level){
+   return level >= 0 && level < SIMD_LEVELS ? simdNames[level] : "unknown";
+}
@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Runtime selection of the vector instruction set ¤¤           //
+//                                                                    //
+//    The simd engines are built with every instruction set the       //
+//    compiler knows and pick the widest one the CPU supports when    //
+//    they start, so one executable runs on every x86-64 machine      //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef SIMD_H
+#define SIMD_H
+
+typedef enum {
+   SIMD_SCALAR,
+   SIMD_AVX2,     // 4 doubles / 8 floats
+   SIMD_AVX512,   // 8 doubles / 16 floats (AVX-512F)
+   SIMD_LEVELS
+} SimdLevel;
+
+// Only GCC, Clang and MSVC on x86 get the vector code paths
+#if (defined(__GNUC__) || defined(_MSC_VER)) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define HAVE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang compile a function for an instruction set with an
+// attribute, MSVC accepts the intrinsics without one
+#if defined(HAVE_SIMD_X86) && defined(__GNUC__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+// Highest level the engines may use (--simd), SIMD_AVX512 by default
+extern int simdLimit;
+
+// Widest level supported by both the CPU and the compiler, up to simdLimit
+int simdLevel(void);
+// Level with the given name (scalar, avx2, avx512), -1 when there is none
+int simdFromName(const char *name);
+const char *simdName(int level);
+
+#endif // SIMD_H
@@ -0,0 +1,161 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "integrator.h"
+#include "speculate.h"
+#include "timing.h"
+#include "trace.h"
+
+// The next frame as the thread computes it
+typedef struct {
+   satellite *sats;
+   int count;
+   int capacity;
+   int mouseX;
+   int mouseY;
+   long long forceEvaluations;
+   uint64_t runTime;
+} SpeculationJob;
+
+static const PhysicsEngine *physics = NULL;
+static int speculateThreads = 0;
+static SpeculationJob job;
+static int pending = 0;         // job is owned by the thread, main thread only
+
+static SDL_Thread *thread = NULL;
+static SDL_sem *jobReady = NULL;
+static SDL_sem *jobDone = NULL;
+static SDL_atomic_t stopping;
+
+// Main thread only
+static unsigned int started = 0, hits = 0, misses = 0;
+static uint64_t hiddenTime = 0;  // physics of the committed frames
+static uint64_t wastedTime = 0;  // physics of the discarded frames
+static uint64_t waitTime = 0;    // frame loop waiting for the thread
+
+static int speculateThread(void *data){
+   (void)data;
+#ifdef _OPENMP
+   // The ICV of this thread only, the frame loop keeps its threads
+   omp_set_num_threads(speculateThreads);
+#endif
+   traceSetOpenmpRows(TRACE_TID_OPENMP_SPECULATE);
+   for (;;) {
+      SDL_SemWait(jobReady);
+      if (SDL_AtomicGet(&stopping)) {
+         break;
+      }
+      uint64_t start = timingNow();
+      frameForceEvaluations = 0;
+      physics->run(job.sats, job.count, job.mouseX, job.mouseY);
+      job.forceEvaluations = frameForceEvaluations;
+      uint64_t end = timingNow();
+      job.runTime = end - start;
+      traceSpan("speculative physics", "speculate", TRACE_TID_SPECULATE, start, end,
+                "satellites", job.count);
+      SDL_SemPost(jobDone);
+   }
+   return 0;
+}
+
+void speculateInit(const PhysicsEngine *engine, int threads){
+   speculateThreads = threads;
+   if (!speculateThreads) {
+      return;
+   }
+   physics = engine;
+   SDL_AtomicSet(&stopping, 0);
+   jobReady = SDL_CreateSemaphore(0);
+   jobDone = SDL_CreateSemaphore(0);
+   thread = SDL_CreateThread(speculateThread, "speculate", NULL);
+   printf("Speculating the physics of the next frame on %d threads\n", speculateThreads);
+}
+
+void speculateStart(const satellite *sats, int count, int mouseX, int mouseY){
+   if (!thread || pending) {
+      return;
+   }
+   if (count > job.capacity) {
+      alignedFree(job.sats);
+      job.sats = (satellite*)alignedAlloc(sizeof(satellite) * count);
+      if (!job.sats) {
+         printf("Out of memory for %d speculated satellites\n", count);
+         exit(-1);
+      }
+      job.capacity = count;
+   }
+   memcpy(job.sats, sats, sizeof(satellite) * count);
+   job.count = count;
+   job.mouseX = mouseX;
+   job.mouseY = mouseY;
+   pending = 1;
+   started++;
+   SDL_SemPost(jobReady);
+}
+
+int speculateCommit(satellite *sats, int count, int mouseX, int mouseY){
+   if (!pending) {
+      return 0;
+   }
+   uint64_t start = timingNow();
+   SDL_SemWait(jobDone);
+   pending = 0;
+   waitTime += timingNow() - start;
+   if (mouseX != job.mouseX || mouseY != job.mouseY || count != job.count) {
+      misses++;
+      wastedTime += job.runTime;
+      return 0;
+   }
+   memcpy(sats, job.sats, sizeof(satellite) * count);
+   frameForceEvaluations = job.forceEvaluations;
+   hits++;
+   hiddenTime += job.runTime;
+   return 1;
+}
+
+void speculateDestroy(void){
+   if (!thread) {
+      return;
+   }
+   if (pending) {
+      SDL_SemWait(jobDone);
+      pending = 0;
+   }
+   SDL_AtomicSet(&stopping, 1);
+   SDL_SemPost(jobReady);
+   SDL_WaitThread(thread, NULL);
+   SDL_DestroySemaphore(jobReady);
+   SDL_DestroySemaphore(jobDone);
+   thread = NULL;
+   alignedFree(job.sats);
+   memset(&job, 0, sizeof(job));
+}
+
+void speculatePrint(void){
+   if (!speculateThreads) {
+      return;
+   }
+   unsigned int decided = hits + misses;
+   printf("Speculation: %u of %u frames committed (%.1f%%), hiding %.3f ms of physics\n",
+          hits, decided, decided ? 100.0 * hits / decided : 0.0, hiddenTime / 1e6);
+   printf("  %u discarded wasting %.3f ms, frame loop waited %.3f ms for the thread\n",
+          misses, wastedTime / 1e6, waitTime / 1e6);
+}
+
+void speculatePrintJson(FILE *f){
+   unsigned int decided = hits + misses;
+   fprintf(f, "{\"threads\":%d,\"started\":%u,\"hits\":%u,\"misses\":%u,\"hit_rate\":%.4f,"
+              "\"hidden_ms\":%.6f,\"wasted_ms\":%.6f,\"wait_ms\":%.6f}",
+           speculateThreads, started, hits, misses, decided ? (double)hits / decided : 0.0,
+           hiddenTime / 1e6, wastedTime / 1e6, waitTime / 1e6);
+}
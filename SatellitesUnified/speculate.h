@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Speculative physics ¤¤                                       //
+//                                                                    //
+//    While a frame renders, a separate thread already runs the       //
+//    physics of the next frame with the black hole where it is now.  //
+//    If the black hole has not moved when the next frame starts, its //
+//    physics is only a copy; otherwise the result is thrown away and //
+//    the physics runs again as usual                                 //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef SPECULATE_H
+#define SPECULATE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "satellites.h"
+
+// Starts the thread running engine with threads OpenMP threads
+// (0 disables speculation)
+void speculateInit(const PhysicsEngine *engine, int threads);
+
+// Starts the physics of the next frame from sats, assuming the black hole
+// stays at (mouseX, mouseY). Call after the physics of the current frame.
+void speculateStart(const satellite *sats, int count, int mouseX, int mouseY);
+
+// Waits for the speculation started in the previous frame. Returns 1 and
+// copies its result to sats when it was computed for (mouseX, mouseY),
+// 0 when the physics must run as usual.
+int speculateCommit(satellite *sats, int count, int mouseX, int mouseY);
+
+// Waits for the last speculation and stops the thread
+void speculateDestroy(void);
+
+void speculatePrint(void);
+// {...} JSON object
+void speculatePrintJson(FILE *f);
+
+#endif // SPECULATE_H
@@ -0,0 +1,130 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "timing.h"
+
+// Counter ticks per second, set by timingInit() before any thread starts
+static uint64_t frequency = 0;
+
+void timingInit(void){
+   frequency = SDL_GetPerformanceFrequency();
+}
+
+uint64_t timingNow(void){
+   // SDL picks the best monotonic counter of the platform
+   // (QueryPerformanceCounter, mach_absolute_time, CLOCK_MONOTONIC)
+   uint64_t counter = SDL_GetPerformanceCounter();
+   // Split to avoid overflowing counter * 1e9
+   return (counter / frequency) * 1000000000ull +
+          (counter % frequency) * 1000000000ull / frequency;
+}
+
+static int bucketIndex(uint64_t ns){
+   if (ns < (1ull << TIMING_SUB_BITS)) {
+      return (int)ns;
+   }
+   int bits = 63;
+   while (!(ns >> bits)) {
+      --bits;
+   }
+   if (bits > TIMING_MAX_BITS) {
+      return TIMING_BUCKETS - 1;
+   }
+   int sub = (int)((ns >> (bits - TIMING_SUB_BITS)) & ((1 << TIMING_SUB_BITS) - 1));
+   return ((bits - TIMING_SUB_BITS + 1) << TIMING_SUB_BITS) + sub;
+}
+
+// Largest value that falls into the bucket
+static uint64_t bucketUpperBound(int index){
+   if (index < (1 << TIMING_SUB_BITS)) {
+      return (uint64_t)index;
+   }
+   int bits = (index >> TIMING_SUB_BITS) + TIMING_SUB_BITS - 1;
+   uint64_t sub = (uint64_t)(index & ((1 << TIMING_SUB_BITS) - 1));
+   uint64_t width = 1ull << (bits - TIMING_SUB_BITS);
+   return (1ull << bits) + (sub + 1) * width - 1;
+}
+
+void timingReset(TimingHistogram *h){
+   memset(h, 0, sizeof(*h));
+}
+
+void timingRecord(TimingHistogram *h, uint64_t ns){
+   if (h->count == 0 || ns < h->min) {
+      h->min = ns;
+   }
+   if (ns > h->max) {
+      h->max = ns;
+   }
+   if (h->count > 0) {
+      h->jitterSum += ns > h->previous ? ns - h->previous : h->previous - ns;
+   }
+   h->previous = ns;
+   h->count++;
+   h->sum += ns;
+   h->buckets[bucketIndex(ns)]++;
+}
+
+uint64_t timingPercentile(const TimingHistogram *h, double p){
+   if (h->count == 0) {
+      return 0;
+   }
+   // Nearest rank, 1-based: the smallest sample with at least p% of the
+   // samples at or below it
+   uint64_t rank = (uint64_t)ceil(p * (double)h->count / 100.0);
+   if (rank < 1) {
+      rank = 1;
+   }
+   if (rank > h->count) {
+      rank = h->count;
+   }
+   uint64_t seen = 0;
+   for (int i = 0; i < TIMING_BUCKETS; ++i) {
+      seen += h->buckets[i];
+      if (seen >= rank) {
+         uint64_t value = bucketUpperBound(i);
+         // The bucket bound can overshoot the largest real sample
+         return value > h->max ? h->max : (value < h->min ? h->min : value);
+      }
+   }
+   return h->max;
+}
+
+double timingMean(const TimingHistogram *h){
+   return h->count ? (double)h->sum / (double)h->count : 0.0;
+}
+
+double timingJitter(const TimingHistogram *h){
+   return h->count > 1 ? (double)h->jitterSum / (double)(h->count - 1) : 0.0;
+}
+
+void timingPrint(const char *name, const TimingHistogram *h){
+   printf("%-10s n=%-6llu mean %9.3f  p50 %9.3f  p90 %9.3f  p99 %9.3f  max %9.3f  jitter %8.3f ms\n",
+          name, (unsigned long long)h->count,
+          timingMean(h) / 1e6,
+          timingPercentile(h, 50.0) / 1e6,
+          timingPercentile(h, 90.0) / 1e6,
+          timingPercentile(h, 99.0) / 1e6,
+          h->max / 1e6,
+          timingJitter(h) / 1e6);
+}
+
+void timingPrintJson(FILE *f, const char *name, const TimingHistogram *h){
+   fprintf(f, "\"%s\":{\"n\":%llu,\"mean_ms\":%.6f,\"p50_ms\":%.6f,\"p90_ms\":%.6f,"
+              "\"p99_ms\":%.6f,\"max_ms\":%.6f,\"jitter_ms\":%.6f}",
+           name, (unsigned long long)h->count,
+           timingMean(h) / 1e6,
+           timingPercentile(h, 50.0) / 1e6,
+           timingPercentile(h, 90.0) / 1e6,
+           timingPercentile(h, 99.0) / 1e6,
+           h->max / 1e6,
+           timingJitter(h) / 1e6);
+}
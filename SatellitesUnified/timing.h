@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Frame stage timing ¤¤                                        //
+//                                                                    //
+//    Monotonic nanosecond timer and a log-linear histogram per       //
+//    stage, used for the p50/p90/p99/max and jitter reports          //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Values below 2^TIMING_SUB_BITS ns get their own bucket, above that every
+// power of two is split into 2^TIMING_SUB_BITS buckets (max ~3% error)
+#define TIMING_SUB_BITS 5
+#define TIMING_MAX_BITS 40 // ~18 minutes, longer samples go to the last bucket
+#define TIMING_BUCKETS ((TIMING_MAX_BITS - TIMING_SUB_BITS + 2) << TIMING_SUB_BITS)
+
+typedef struct {
+   uint64_t count;
+   uint64_t sum;        // ns
+   uint64_t min;        // ns
+   uint64_t max;        // ns
+   uint64_t previous;   // last sample, for the jitter
+   uint64_t jitterSum;  // sum of |sample - previous sample|
+   uint32_t buckets[TIMING_BUCKETS];
+} TimingHistogram;
+
+// Reads the counter frequency. Call once at startup, before any thread
+// that calls timingNow() starts.
+void timingInit(void);
+// Monotonic time in nanoseconds
+uint64_t timingNow(void);
+
+void timingReset(TimingHistogram *h);
+void timingRecord(TimingHistogram *h, uint64_t ns);
+
+// Value at percentile p (0...100) in ns, accurate to the bucket width
+uint64_t timingPercentile(const TimingHistogram *h, double p);
+double timingMean(const TimingHistogram *h);
+double timingJitter(const TimingHistogram *h);
+
+// Human readable one line summary in milliseconds
+void timingPrint(const char *name, const TimingHistogram *h);
+// "name":{...} JSON member in milliseconds
+void timingPrintJson(FILE *f, const char *name, const TimingHistogram *h);
+
+#endif // TIMING_H
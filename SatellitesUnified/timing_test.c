@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Percentiles of the timing histograms ¤¤                      //
+//                                                                    //
+//    Samples below 2^TIMING_SUB_BITS ns have buckets of their own,   //
+//    so the nearest-rank percentiles are exact. Run with ctest.      //
+////////////////////////////////////////////////////////////////////////
+
+#include "timing.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+// Histogram of the samples 1, 2, ..., count ns
+static void fill(TimingHistogram *h, int count){
+   timingReset(h);
+   for (int i = 1; i <= count; ++i) {
+      timingRecord(h, (uint64_t)i);
+   }
+}
+
+static void expect(int count, double p, uint64_t wanted){
+   TimingHistogram h;
+   fill(&h, count);
+   uint64_t value = timingPercentile(&h, p);
+   if (value != wanted) {
+      printf("n=%d p%g: got sample %llu, expected %llu\n", count, p,
+             (unsigned long long)value, (unsigned long long)wanted);
+      failures++;
+   }
+}
+
+int main(void){
+   // Few samples, as in the ensemble summaries
+   expect(6, 50.0, 3);
+   expect(6, 90.0, 6);
+   expect(6, 99.0, 6);
+   expect(1, 50.0, 1);
+   expect(1, 99.0, 1);
+   expect(10, 90.0, 9);
+   expect(20, 99.0, 20);
+   expect(20, 0.0, 1);
+   expect(20, 100.0, 20);
+   if (failures) {
+      printf("%d percentile checks failed\n", failures);
+      return 1;
+   }
+   printf("Percentile checks passed\n");
+   return 0;
+}
@@ -0,0 +1,167 @@
+#ifdef _WIN32
+#include "SDL.h"
+#elif defined(__APPLE__)
+#include "SDL.h"
+#else
+#include "SDL2/SDL.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "timing.h"
+#include "trace.h"
+
+typedef struct {
+   const char *name;
+   const char *category;
+   const char *argName;
+   long long argValue;
+   uint64_t start;   // ns
+   uint64_t end;     // ns
+   int tid;
+} TraceEvent;
+
+static char tracePath[512];
+static TraceEvent *events = NULL;
+static SDL_atomic_t eventCount;
+static uint64_t traceStart = 0;
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+static TRACE_THREAD_LOCAL int openmpRows = TRACE_TID_OPENMP;
+
+// Names of the OpenMP rows, by the thread that started the team
+static const struct {
+   int rows;
+   const char *name;
+} openmpRowNames[] = {
+   {TRACE_TID_OPENMP, "OpenMP thread %d"},
+   {TRACE_TID_OPENMP_PHYSICS_WORKER, "physics worker OpenMP %d"},
+   {TRACE_TID_OPENMP_GRAPHICS_WORKER, "graphics worker OpenMP %d"},
+   {TRACE_TID_OPENMP_SPECULATE, "speculation OpenMP %d"},
+};
+
+int traceOpen(const char *path){
+   events = (TraceEvent*)malloc(sizeof(TraceEvent) * TRACE_MAX_EVENTS);
+   if (!events) {
+      printf("Out of memory for the trace\n");
+      return -1;
+   }
+   snprintf(tracePath, sizeof(tracePath), "%s", path);
+   SDL_AtomicSet(&eventCount, 0);
+   traceStart = timingNow();
+   printf("Tracing to %s\n", tracePath);
+   return 0;
+}
+
+int traceEnabled(void){
+   return events != NULL;
+}
+
+void traceSpan(const char *name, const char *category, int tid,
+               uint64_t startNs, uint64_t endNs,
+               const char *argName, long long argValue){
+   if (!events) {
+      return;
+   }
+   int index = SDL_AtomicAdd(&eventCount, 1);
+   if (index >= TRACE_MAX_EVENTS) {
+      return;
+   }
+   TraceEvent event = {.name = name, .category = category, .argName = argName,
+                       .argValue = argValue, .start = startNs, .end = endNs, .tid = tid};
+   events[index] = event;
+}
+
+void traceSetOpenmpRows(int rows){
+   openmpRows = rows;
+}
+
+int traceOpenmpRows(void){
+   return openmpRows;
+}
+
+int traceOpenmpThread(int rows){
+#ifdef _OPENMP
+   int thread = omp_get_thread_num();
+   // Larger teams share the last row
+   return rows + (thread < TRACE_OPENMP_ROWS ? thread : TRACE_OPENMP_ROWS - 1);
+#else
+   return rows;
+#endif
+}
+
+static void writeThreadName(FILE *f, int tid, const char *name, int number){
+   fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", tid);
+   fprintf(f, name, number);
+   fprintf(f, "\"}},\n");
+}
+
+void traceClose(void){
+   if (!events) {
+      return;
+   }
+   int count = SDL_AtomicGet(&eventCount);
+   int dropped = 0;
+   if (count > TRACE_MAX_EVENTS) {
+      dropped = count - TRACE_MAX_EVENTS;
+      count = TRACE_MAX_EVENTS;
+   }
+   FILE *f = fopen(tracePath, "w");
+   if (!f) {
+      printf("Cannot write trace: %s\n", tracePath);
+   } else {
+      fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      writeThreadName(f, TRACE_TID_MAIN, "main", 0);
+      writeThreadName(f, TRACE_TID_SAMPLER, "sampler", 0);
+      writeThreadName(f, TRACE_TID_SPECULATE, "speculation", 0);
+      writeThreadName(f, TRACE_TID_PHYSICS_WORKER, "physics worker", 0);
+      writeThreadName(f, TRACE_TID_GRAPHICS_WORKER, "graphics worker", 0);
+      writeThreadName(f, TRACE_TID_CHECKPOINT, "checkpoint writer", 0);
+      // Name every OpenMP thread that shows up
+      for (size_t r = 0; r < sizeof(openmpRowNames) / sizeof(openmpRowNames[0]); ++r) {
+         int rows = openmpRowNames[r].rows;
+         int maxOpenmp = -1;
+         for (int i = 0; i < count; ++i) {
+            int thread = events[i].tid - rows;
+            if (thread >= 0 && thread < TRACE_OPENMP_ROWS && thread > maxOpenmp) {
+               maxOpenmp = thread;
+            }
+         }
+         for (int t = 0; t <= maxOpenmp; ++t) {
+            writeThreadName(f, rows + t, openmpRowNames[r].name, t);
+         }
+      }
+      for (int i = 0; i < count; ++i) {
+         const TraceEvent *e = &events[i];
+         // Microseconds since traceOpen()
+         fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                    "\"ts\":%.3f,\"dur\":%.3f",
+                 e->name, e->category, e->tid,
+                 (double)(int64_t)(e->start - traceStart) / 1e3,
+                 (double)(e->end - e->start) / 1e3);
+         if (e->argName) {
+            fprintf(f, ",\"args\":{\"%s\":%lld}", e->argName, e->argValue);
+         }
+         fprintf(f, "},\n");
+      }
+      // Last one without a trailing comma
+      fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"satellites\"}}\n");
+      fprintf(f, "]}\n");
+      fclose(f);
+      printf("Wrote %d trace events to %s", count, tracePath);
+      if (dropped) {
+         printf(", %d dropped", dropped);
+      }
+      printf("\n");
+   }
+   free(events);
+   events = NULL;
+}
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Timeline trace ¤¤                                            //
+//                                                                    //
+//    Collects begin/end times of the frame stages and of the work    //
+//    of every thread, and writes them as Chrome trace-event JSON     //
+//    (chrome://tracing, ui.perfetto.dev) with --trace <file>         //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Thread ids of the timeline rows
+#define TRACE_TID_MAIN 0
+#define TRACE_TID_SAMPLER 1
+#define TRACE_TID_SPECULATE 2
+#define TRACE_TID_PHYSICS_WORKER 3   // --pipeline
+#define TRACE_TID_GRAPHICS_WORKER 4
+#define TRACE_TID_CHECKPOINT 5
+// First rows of the OpenMP teams started by each thread, + omp_get_thread_num()
+#define TRACE_TID_OPENMP 100
+#define TRACE_TID_OPENMP_PHYSICS_WORKER 200
+#define TRACE_TID_OPENMP_GRAPHICS_WORKER 300
+#define TRACE_TID_OPENMP_SPECULATE 400
+#define TRACE_OPENMP_ROWS 100   // team size that fits between them
+
+// Events kept in memory until traceClose(), later ones are dropped
+#define TRACE_MAX_EVENTS (1 << 20)
+
+// Starts collecting events, returns 0 on success
+int traceOpen(const char *path);
+// Writes the file and frees the events
+void traceClose(void);
+
+int traceEnabled(void);
+
+// Sets where the OpenMP teams started by the calling thread go, one of
+// the TRACE_TID_OPENMP rows. The main thread keeps TRACE_TID_OPENMP.
+void traceSetOpenmpRows(int rows);
+// The rows of the calling thread. Read them before a parallel region:
+// the team threads do not share the setting of the thread that starts it.
+int traceOpenmpRows(void);
+// Timeline row of the calling thread of an OpenMP team started with rows
+int traceOpenmpThread(int rows);
+
+// Adds a span from startNs to endNs (timingNow() times). name and
+// category must be string literals, argName may be NULL. Safe to call
+// from any thread.
+void traceSpan(const char *name, const char *category, int tid,
+               uint64_t startNs, uint64_t endNs,
+               const char *argName, long long argValue);
+
+#endif // TRACE_H
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trajectory.h"
+
+typedef struct {
+   unsigned int frame;
+   int x;
+   int y;
+} TrajectoryPoint;
+
+// Loaded trajectory, sorted by frame
+static TrajectoryPoint *points = NULL;
+static int pointCount = 0;
+// Index of the last point used, frames normally only move forward
+static int cursor = 0;
+
+static FILE *recording = NULL;
+
+int trajectoryLoad(const char *path){
+   FILE *f = fopen(path, "r");
+   if (!f) {
+      printf("Cannot open trajectory: %s\n", path);
+      return -1;
+   }
+   int capacity = 0;
+   char line[256];
+   int lineNumber = 0;
+   while (fgets(line, sizeof(line), f)) {
+      lineNumber++;
+      char *comment = strchr(line, '#');
+      if (comment) {
+         *comment = '\0';
+      }
+      TrajectoryPoint point;
+      double timeMs;
+      int fields = sscanf(line, "%u %lf %d %d", &point.frame, &timeMs, &point.x, &point.y);
+      if (fields <= 0) {
+         continue; // Empty line
+      }
+      if (fields != 4 || (pointCount > 0 && point.frame <= points[pointCount-1].frame)) {
+         printf("%s:%d: expected \"frame time_ms x y\" with increasing frames\n", path, lineNumber);
+         fclose(f);
+         return -1;
+      }
+      if (pointCount == capacity) {
+         capacity = capacity ? capacity * 2 : 256;
+         points = (TrajectoryPoint*)realloc(points, sizeof(TrajectoryPoint) * capacity);
+         if (!points) {
+            printf("Out of memory for trajectory %s\n", path);
+            exit(-1);
+         }
+      }
+      points[pointCount++] = point;
+   }
+   fclose(f);
+   cursor = 0;
+   printf("Replaying %d trajectory points from %s\n", pointCount, path);
+   return 0;
+}
+
+int trajectoryPosition(unsigned int frame, int *x, int *y){
+   if (pointCount == 0 || frame < points[0].frame) {
+      return 0;
+   }
+   if (points[cursor].frame > frame) {
+      cursor = 0;
+   }
+   while (cursor + 1 < pointCount && points[cursor+1].frame <= frame) {
+      cursor++;
+   }
+   *x = points[cursor].x;
+   *y = points[cursor].y;
+   return 1;
+}
+
+int trajectoryStartRecording(const char *path){
+   recording = fopen(path, "w");
+   if (!recording) {
+      printf("Cannot create trajectory: %s\n", path);
+      return -1;
+   }
+   fprintf(recording, "# frame time_ms x y\n");
+   printf("Recording trajectory to %s\n", path);
+   return 0;
+}
+
+void trajectoryRecord(unsigned int frame, double timeMs, int x, int y){
+   if (recording) {
+      fprintf(recording, "%u %.3f %d %d\n", frame, timeMs, x, y);
+   }
+}
+
+void trajectoryClose(void){
+   if (recording) {
+      fclose(recording);
+      recording = NULL;
+   }
+   free(points);
+   points = NULL;
+   pointCount = 0;
+   cursor = 0;
+}
@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Black hole trajectories ¤¤                                   //
+//                                                                    //
+//    Records the black hole position of every frame to a file and    //
+//    replays it later, so benchmarks get the same input every run    //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+// File format, one frame per line, '#' starts a comment:
+//    frame time_ms x y
+// time_ms is the time since the first frame when the line was recorded.
+// Replay is keyed on the frame number so it does not depend on the speed
+// of the machine. Frames missing from the file keep the position of the
+// previous line, frames before the first line keep the caller's position.
+
+// Loads a trajectory for trajectoryPosition(), returns 0 on success
+int trajectoryLoad(const char *path);
+// Sets *x and *y to the position of frame, returns 0 when no trajectory
+// is loaded or the frame is before its first line
+int trajectoryPosition(unsigned int frame, int *x, int *y);
+
+// Starts writing every trajectoryRecord() to path, returns 0 on success
+int trajectoryStartRecording(const char *path);
+void trajectoryRecord(unsigned int frame, double timeMs, int x, int y);
+
+// Closes the recording and frees the loaded trajectory
+void trajectoryClose(void);
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,206 @@
+#include <math.h> // INFINITY
+#include <stdlib.h> // abs
+#include <string.h>
+
+#include "validation.h"
+
+// The histogram is printed in power of two bins: 0, 1, 2-3, 4-7 ... 128-255
+#define HISTOGRAM_BINS 9
+
+static const char *channelNames[3] = {"red", "green", "blue"};
+
+void validationReset(ValidationReport *r){
+   memset(r, 0, sizeof(*r));
+   r->worstPositionSatellite = -1;
+   r->worstVelocitySatellite = -1;
+}
+
+int validationAddPixel(ValidationReport *r, color_u8 reference, color_u8 actual){
+   int errors[3] = {abs(reference.red - actual.red),
+                    abs(reference.green - actual.green),
+                    abs(reference.blue - actual.blue)};
+   for (int c = 0; c < 3; ++c) {
+      r->errorHistogram[c][errors[c]]++;
+      r->errorSum[c] += errors[c];
+      r->squaredErrorSum += (uint64_t)(errors[c] * errors[c]);
+      if (errors[c] > r->maxError[c]) {
+         r->maxError[c] = errors[c];
+      }
+   }
+   r->pixels++;
+   if (errors[0] > ALLOWED_ERROR || errors[1] > ALLOWED_ERROR || errors[2] > ALLOWED_ERROR) {
+      r->pixelsOverAllowed++;
+      return 1;
+   }
+   return 0;
+}
+
+int validationAddSatellite(ValidationReport *r, const satellite *reference,
+                           const satellite *actual, int index, unsigned int frame){
+   double positionError = hypot((double)actual->position.x - reference->position.x,
+                                (double)actual->position.y - reference->position.y);
+   double velocityError = hypot((double)actual->velocity.x - reference->velocity.x,
+                                (double)actual->velocity.y - reference->velocity.y);
+   if (positionError > r->worstPositionError) {
+      r->worstPositionError = positionError;
+      r->worstPositionSatellite = index;
+      r->worstPositionFrame = frame;
+   }
+   if (velocityError > r->worstVelocityError) {
+      r->worstVelocityError = velocityError;
+      r->worstVelocitySatellite = index;
+      r->worstVelocityFrame = frame;
+   }
+   int inexact = memcmp(actual, reference, sizeof(satellite)) != 0;
+   r->inexactSatellites += (uint64_t)inexact;
+   // Approximate engines are compared by distance, NaN fails too
+   int wrong = r->satelliteTolerance > 0.0 ?
+      !(positionError <= r->satelliteTolerance) : inexact;
+   r->mismatchedSatellites += (uint64_t)wrong;
+   return wrong;
+}
+
+int validationComparePixels(ValidationReport *r, const color_u8 *reference,
+                            const color_u8 *actual, int count, int width,
+                            unsigned int frame){
+   int countErrors = 0;
+   for (int i = 0; i < count; ++i) {
+      if (validationAddPixel(r, reference[i], actual[i])) {
+         if (countErrors < PRINTED_ERRORS) {
+            printf("Pixel x=%d y=%d value: %d, %d, %d. Should have been: %d, %d, %d\n",
+                   i % width, i / width,
+                   actual[i].red, actual[i].green, actual[i].blue,
+                   reference[i].red, reference[i].green, reference[i].blue);
+         }
+         countErrors++;
+      }
+   }
+   r->pixelFrames++;
+   if (countErrors > ALLOWED_NUMBER_OF_ERRORS) {
+      r->failedPixelFrames++;
+      printf("Too many errors (%d) in frame %u\n", countErrors, frame);
+   } else {
+      printf("Error check passed with acceptable number of wrong pixels: %d\n", countErrors);
+   }
+   return countErrors;
+}
+
+int validationCompareSatellites(ValidationReport *r, const satellite *reference,
+                                const satellite *actual, int count,
+                                unsigned int frame){
+   int mismatches = 0;
+   for (int i = 0; i < count; ++i) {
+      if (validationAddSatellite(r, &reference[i], &actual[i], i, frame)) {
+         if (mismatches < PRINTED_ERRORS) {
+            printf("Incorrect satellite data of satellite: %d\n", i);
+         }
+         mismatches++;
+      }
+   }
+   r->satelliteFrames++;
+   if (mismatches) {
+      r->failedSatelliteFrames++;
+      printf("%d incorrect satellites in frame %u\n", mismatches, frame);
+   }
+   return mismatches;
+}
+
+int validationRan(const ValidationReport *r){
+   return r->pixelFrames > 0 || r->satelliteFrames > 0;
+}
+
+int validationPassed(const ValidationReport *r){
+   return r->failedPixelFrames == 0 && r->failedSatelliteFrames == 0;
+}
+
+double validationMeanError(const ValidationReport *r, int channel){
+   return r->pixels ? (double)r->errorSum[channel] / (double)r->pixels : 0.0;
+}
+
+double validationPsnr(const ValidationReport *r){
+   if (r->squaredErrorSum == 0) {
+      return INFINITY;
+   }
+   double mse = (double)r->squaredErrorSum / (3.0 * (double)r->pixels);
+   return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+// Pixels of channel in power of two bin b
+static uint64_t histogramBin(const ValidationReport *r, int channel, int b){
+   int first = b == 0 ? 0 : 1 << (b - 1);
+   int last = b == 0 ? 0 : (1 << b) - 1;
+   uint64_t sum = 0;
+   for (int e = first; e <= last; ++e) {
+      sum += r->errorHistogram[channel][e];
+   }
+   return sum;
+}
+
+void validationPrint(const char *title, const ValidationReport *r){
+   if (!validationRan(r)) {
+      printf("%s: not run, no frames were compared\n", title);
+      return;
+   }
+   // Physics only runs (--ensemble) compare no pixels
+   printf("%s over %u frames: %s\n", title, r->pixelFrames ? r->pixelFrames : r->satelliteFrames,
+          validationPassed(r) ? "passed" : "FAILED");
+   printf("  pixels     %llu compared, %llu over allowed error %d, %u frames failed, PSNR %.2f dB\n",
+          (unsigned long long)r->pixels, (unsigned long long)r->pixelsOverAllowed,
+          ALLOWED_ERROR, r->failedPixelFrames, validationPsnr(r));
+   printf("  |error|    max   mean      0      1    2-3    4-7   8-15  16-31  32-63 64-127   128-\n");
+   for (int c = 0; c < 3; ++c) {
+      printf("  %-8s %5d %6.3f", channelNames[c], r->maxError[c], validationMeanError(r, c));
+      for (int b = 0; b < HISTOGRAM_BINS; ++b) {
+         printf(" %6llu", (unsigned long long)histogramBin(r, c, b));
+      }
+      printf("\n");
+   }
+   printf("  satellites %llu not bit exact, %llu over tolerance %g, %u frames failed\n",
+          (unsigned long long)r->inexactSatellites, (unsigned long long)r->mismatchedSatellites,
+          r->satelliteTolerance, r->failedSatelliteFrames);
+   if (r->worstPositionSatellite >= 0) {
+      printf("  worst position error %.9g (satellite %d, frame %u)\n",
+             r->worstPositionError, r->worstPositionSatellite, r->worstPositionFrame);
+   } else if (r->satelliteFrames) {
+      printf("  worst position error 0\n");
+   }
+   if (r->worstVelocitySatellite >= 0) {
+      printf("  worst velocity error %.9g (satellite %d, frame %u)\n",
+             r->worstVelocityError, r->worstVelocitySatellite, r->worstVelocityFrame);
+   } else if (r->satelliteFrames) {
+      printf("  worst velocity error 0\n");
+   }
+}
+
+void validationPrintJson(FILE *f, const ValidationReport *r){
+   double psnr = validationPsnr(r);
+   fprintf(f, "{\"passed\":%s,\"pixel_frames\":%u,\"failed_pixel_frames\":%u,"
+              "\"pixels\":%llu,\"pixels_over_allowed\":%llu,\"allowed_error\":%d,",
+           !validationRan(r) ? "null" : validationPassed(r) ? "true" : "false", r->pixelFrames, r->failedPixelFrames,
+           (unsigned long long)r->pixels, (unsigned long long)r->pixelsOverAllowed,
+           ALLOWED_ERROR);
+   // Identical images have no finite PSNR
+   if (isinf(psnr)) {
+      fprintf(f, "\"psnr_db\":null,");
+   } else {
+      fprintf(f, "\"psnr_db\":%.4f,", psnr);
+   }
+   fprintf(f, "\"channels\":{");
+   for (int c = 0; c < 3; ++c) {
+      fprintf(f, "%s\"%s\":{\"max_error\":%d,\"mean_error\":%.6f,\"histogram\":[",
+              c ? "," : "", channelNames[c], r->maxError[c], validationMeanError(r, c));
+      for (int b = 0; b < HISTOGRAM_BINS; ++b) {
+         fprintf(f, "%s%llu", b ? "," : "", (unsigned long long)histogramBin(r, c, b));
+      }
+      fprintf(f, "]}");
+   }
+   fprintf(f, "},\"satellite_frames\":%u,\"failed_satellite_frames\":%u,"
+              "\"satellite_tolerance\":%g,\"inexact_satellites\":%llu,\"mismatched_satellites\":%llu,"
+              "\"worst_position_error\":%.9g,\"worst_position_satellite\":%d,\"worst_position_frame\":%u,"
+              "\"worst_velocity_error\":%.9g,\"worst_velocity_satellite\":%d,\"worst_velocity_frame\":%u}",
+           r->satelliteFrames, r->failedSatelliteFrames,
+           r->satelliteTolerance, (unsigned long long)r->inexactSatellites,
+           (unsigned long long)r->mismatchedSatellites,
+           r->worstPositionError, r->worstPositionSatellite, r->worstPositionFrame,
+           r->worstVelocityError, r->worstVelocitySatellite, r->worstVelocityFrame);
+}
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////
+//    ¤¤ Correctness report ¤¤                                        //
+//                                                                    //
+//    Collects the pixel and satellite differences between an engine  //
+//    and the sequential reference code over all checked frames       //
+////////////////////////////////////////////////////////////////////////
+
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "satellites.h"
+
+// Just some value that barely passes for OpenCL example program
+#define ALLOWED_ERROR 10
+#define ALLOWED_NUMBER_OF_ERRORS 10
+// Wrong pixels printed per frame, the rest are only counted
+#define PRINTED_ERRORS 10
+
+typedef struct {
+   // Pixels
+   unsigned int pixelFrames;        // frames compared
+   unsigned int failedPixelFrames;  // frames with too many wrong pixels
+   uint64_t pixels;                 // pixels compared
+   uint64_t pixelsOverAllowed;      // pixels with a channel error > ALLOWED_ERROR
+   uint64_t errorHistogram[3][256]; // |error| counts per channel (red, green, blue)
+   int maxError[3];
+   uint64_t errorSum[3];
+   uint64_t squaredErrorSum;        // over all channels, for the PSNR
+
+   // Satellites
+   double satelliteTolerance;           // allowed position error in pixels, 0 = bit exact
+   unsigned int satelliteFrames;        // frames compared
+   unsigned int failedSatelliteFrames;  // frames with any satellite over the tolerance
+   uint64_t mismatchedSatellites;       // satellites over the tolerance
+   uint64_t inexactSatellites;          // satellites not bit exact
+   double worstPositionError;           // pixels
+   int worstPositionSatellite;
+   unsigned int worstPositionFrame;
+   double worstVelocityError;           // pixels per time unit
+   int worstVelocitySatellite;
+   unsigned int worstVelocityFrame;
+} ValidationReport;
+
+void validationReset(ValidationReport *r);
+
+// Adds one pixel, returns 1 when a channel is over ALLOWED_ERROR
+int validationAddPixel(ValidationReport *r, color_u8 reference, color_u8 actual);
+// Adds one satellite, returns 1 when it is over satelliteTolerance
+// (not bit exact when the tolerance is 0)
+int validationAddSatellite(ValidationReport *r, const satellite *reference,
+                           const satellite *actual, int index, unsigned int frame);
+
+// Compares count pixels of frame, returns the number over ALLOWED_ERROR
+int validationComparePixels(ValidationReport *r, const color_u8 *reference,
+                            const color_u8 *actual, int count, int width,
+                            unsigned int frame);
+// Compares count satellites, returns the number over satelliteTolerance
+int validationCompareSatellites(ValidationReport *r, const satellite *reference,
+                                const satellite *actual, int count,
+                                unsigned int frame);
+
+// 1 when any frame was compared. A run restored past the checked frames
+// compares none, and then it has neither passed nor failed.
+int validationRan(const ValidationReport *r);
+// 1 when no compared frame failed, also when nothing was compared
+int validationPassed(const ValidationReport *r);
+double validationMeanError(const ValidationReport *r, int channel);
+// Peak signal-to-noise ratio in dB, INFINITY for identical images
+double validationPsnr(const ValidationReport *r);
+
+// Human readable summary, title is e.g. "Correctness"
+void validationPrint(const char *title, const ValidationReport *r);
+// {...} JSON object, "passed" is null when nothing was compared
+void validationPrintJson(FILE *f, const ValidationReport *r);
+
+#endif // VALIDATION_H